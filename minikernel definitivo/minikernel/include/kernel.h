@@ -28,6 +28,138 @@
 #define MUTEX_BLOQUEADO 1
 #define MUTEX_DESBLOQUEADO 0
 
+/* Clases de objetos que comparten la tabla de mutex */
+#define OBJ_MUTEX 0
+#define OBJ_RWLOCK 1
+#define OBJ_CONDICION 2
+#define OBJ_SEMAFORO 3
+#define OBJ_BARRERA 4
+#define OBJ_EVENTOS 5
+#define OBJ_TUBERIA 6
+#define OBJ_COLA 7
+#define OBJ_MEMORIA 8
+
+/* Motivos por los que se despierta a un proceso de una cola de espera */
+#define DESP_EVENTO 0	/* ha ocurrido lo que esperaba */
+#define DESP_PLAZO 1	/* ha vencido el tiempo que podia esperar */
+
+/* Fuentes que se pueden vigilar desde un conjunto de eventos */
+#define EV_TERMINAL 0		/* hay caracteres que leer */
+#define EV_MUTEX 1		/* el mutex ha quedado libre */
+#define EV_TEMPORIZADOR 2	/* ha vencido un periodo */
+#define EV_TUBERIA 3		/* hay datos que leer de la tuberia */
+#define EV_COLA 4		/* hay mensajes en la cola */
+#define MAX_INTERESES 32	/* fuentes vigiladas por conjunto */
+
+#define TAM_TUBERIA 4096	/* capacidad del buffer de una tuberia */
+#define NUM_PRIOS_MSG 32	/* prioridades de mensaje, de 0 a 31 */
+#define MAX_MSGS_COLA 256	/* tope de mensajes de una cola */
+#define MAX_TAM_MSG 1024	/* tope del tamao de un mensaje */
+#define MAX_TAM_MEMORIA (1<<20)	/* tope de un segmento de memoria compartida */
+
+/*
+ * Memoria que se carga a cada proceso, por tipos. La de los objetos
+ * (tuberias, colas y segmentos) se carga a quien los crea
+ */
+#define MEM_PILA 0
+#define MEM_MONTICULO 1
+#define MEM_IPC 2
+#define NUM_TIPOS_MEM 3
+#define LIMITE_MEMORIA (16<<20)	/* limite con el que empieza init */
+#define MAX_MONTICULO (8<<20)	/* tope del monticulo de un proceso */
+#define TROZO_MONTICULO (1<<20)	/* se le reserva en trozos de este tamao */
+#define MAX_TROZOS_MONTICULO (MAX_MONTICULO/TROZO_MONTICULO)
+#define TAM_CONSOLA 4096	/* buffer de salida de la consola */
+#define MARCA_CONSOLA 3072	/* ocupacion a la que se vacia sin esperar */
+#define PLAZO_CONSOLA 5		/* ticks que puede esperar el texto en ella */
+#define TAM_LINEA_CONS 128	/* linea que arma cada proceso */
+
+/* Relojes de obtener_tiempo */
+#define TIEMPO_TICKS 0		/* ticks desde el arranque */
+#define TIEMPO_MONOTONICO 1	/* ns desde el arranque */
+#define TIEMPO_REAL 2		/* ns desde el 1-1-1970 */
+
+/* Preferencia de un rwlock cuando hay lectores y escritores esperando */
+#define PREF_LECTURA 0
+#define PREF_ESCRITURA 1
+
+/*
+ * Tablas de mutex dinamicas. Los mutex salen de una cache de objetos con
+ * un tope de MAX_MUT y la tabla de descriptores de cada proceso crece
+ * por paginas de DESC_POR_PAGINA descriptores, con un bit de ocupacion
+ * por descriptor.
+ */
+#define MAX_MUT 1024		/* tope de mutex en el sistema */
+#define DESC_POR_PAGINA (8*sizeof(unsigned long)) /* bits del mapa */
+#define MAX_PAG_DESC 16		/* paginas de descriptores por proceso */
+#define MAX_MUT_PROC (MAX_PAG_DESC*DESC_POR_PAGINA) /* descriptores por proceso */
+#define TAM_HASH_MUT 64		/* listas de la tabla hash de nombres */
+
+/*
+ * Cache de objetos del kernel de un mismo tipo. Los objetos salen de
+ * bloques de al menos TAM_BLOQUE_CACHE bytes pedidos al HAL, cada uno en
+ * su propia linea de cache, y al liberarse vuelven a la lista de libres
+ * de la cache. El constructor se aplica una sola vez, al partir el
+ * bloque: quien libera un objeto debe dejarlo en su estado construido
+ */
+#define TAM_BLOQUE_CACHE 4096	/* memoria que se pide de una vez */
+#define TAM_LINEA_CACHE 64	/* alineamiento de los objetos */
+#define MAX_NOM_CACHE 11
+
+typedef struct cache_obj{
+	char nombre[MAX_NOM_CACHE+1];
+	int tam;			/* bytes del objeto */
+	int tam_hueco;			/* objeto y enlace, en lineas de cache */
+	int por_bloque;			/* objetos de cada bloque */
+	unsigned long max_objetos;	/* tope de objetos, 0 si no tiene */
+	void (*constructor)(void *);
+	void *libres;			/* enlazados tras el objeto */
+	unsigned long objetos;		/* objetos en los bloques pedidos */
+	unsigned long bloques;
+	unsigned long en_uso;
+	unsigned long max_en_uso;
+	unsigned long reservas;		/* objetos pedidos desde el arranque */
+	struct cache_obj *siguiente;	/* en la lista de caches */
+} cache_obj;
+
+/*
+ * Entrada del informe de estadisticas_caches. Debe coincidir con la
+ * definida en usuario/include/servicios.h
+ */
+typedef struct{
+	char nombre[MAX_NOM_CACHE+1];
+	unsigned long tam;
+	unsigned long objetos;
+	unsigned long bloques;
+	unsigned long en_uso;
+	unsigned long max_en_uso;
+	unsigned long reservas;
+} est_cache;
+
+/*
+ * Informe de estadisticas_memoria, en bytes. Debe coincidir con el
+ * definido en usuario/include/servicios.h
+ */
+typedef struct{
+	unsigned long en_uso;
+	unsigned long max_en_uso;
+	unsigned long limite;
+	unsigned long pila;
+	unsigned long monticulo;
+	unsigned long ipc;
+	unsigned long fallos;		/* peticiones rechazadas por el limite */
+} est_memoria;
+
+/*
+ * Caches del kernel: mutex, paginas de descriptores, intereses de los
+ * conjuntos de eventos y buffers de tuberias
+ */
+cache_obj *caches=NULL;
+cache_obj cache_mutex;
+cache_obj cache_paginas;
+cache_obj cache_intereses;
+cache_obj cache_tuberias;
+
 /*
  *
  * Definicion del tipo que corresponde con el BCP.
@@ -36,17 +168,62 @@
  */
 typedef struct BCP_t *BCPptr;
 
+/*
+ * Pagina de la tabla de descriptores de mutex de un proceso. El bit i
+ * de "mapa" indica si el descriptor i de la pagina esta ocupado.
+ */
+typedef struct pagina_desc {
+	unsigned long mapa;		/* descriptores ocupados */
+	struct mutex *desc[DESC_POR_PAGINA];
+} pagina_desc;
+
 typedef struct BCP_t {
         int id;				/* ident. del proceso */
         int estado;			/* TERMINADO|LISTO|EJECUCION|BLOQUEADO*/
         contexto_t contexto_regs;	/* copia de regs. de UCP */
         void * pila;			/* dir. inicial de la pila */
 	BCPptr siguiente;		/* puntero a otro BCP */
+	BCPptr anterior;		/* BCP anterior en su lista */
+#ifdef DEPURAR_COLAS
+	void *cola;			/* lista en la que esta, o NULL */
+#endif
 	void *info_mem;			/* descriptor del mapa de memoria */
-	unsigned int tiempo_dormir;
+	unsigned long fin_dormir;	/* tick en que despierta si duerme */
 	unsigned int rodaja;
+	int unidades_sem;		/* unidades que espera de un semaforo */
+	unsigned long inicio_espera;	/* tick en que entro en la cola de un mutex */
+	int espera_mutex;		/* 1 si ha esperado en la cola de un mutex */
+	struct mutex *mutex_espera;	/* mutex de un lock_temporizado en curso */
+	struct lista_BCPs *cola_plazo;	/* cola de una espera con plazo en curso */
+	unsigned long plazo_espera;	/* tick en que vence esa espera */
+	BCPptr siguiente_temp;		/* enlaces en lista_temporizados */
+	BCPptr anterior_temp;
+	int espera_exclusiva;		/* 1 si se le despierta de uno en uno */
+	int motivo_desp;		/* DESP_EVENTO|DESP_PLAZO */
+	struct mutex *entrega;		/* mutex libre que se le entrega al despertar */
+	char linea[TAM_LINEA_CONS];	/* linea de salida a medio escribir */
+	int long_linea;			/* caracteres en linea */
+	char *io_buf;			/* buffer de un leer_tuberia bloqueado */
+	int io_tam;			/* bytes que caben en io_buf */
+	int io_hecho;			/* bytes que le ha dejado un escritor */
+	char *trozos_monticulo[MAX_TROZOS_MONTICULO]; /* zonas del monticulo */
+	int tam_trozos[MAX_TROZOS_MONTICULO];	/* bytes que mide cada una */
+	int num_trozos;			/* trozos reservados */
+	int tam_monticulo;		/* bytes en uso del ultimo trozo */
+	unsigned long encarnacion;	/* distingue a los procesos de este BCP */
+	unsigned long memoria[NUM_TIPOS_MEM]; /* bytes cargados de cada tipo */
+	unsigned long mem_en_uso;
+	unsigned long mem_max;
+	unsigned long limite_memoria;
+	unsigned long fallos_memoria;	/* peticiones rechazadas por el limite */
+	unsigned long periodo_alarma;	/* ticks entre alarmas, 0 si no tiene */
+	unsigned long proxima_alarma;	/* tick de la siguiente alarma */
+	int alarmas_vencidas;		/* vencidas sin que las lea el proceso */
+	int esperando_alarma;		/* 1 si esta bloqueado en esperar_alarma */
+	BCPptr siguiente_alarma;	/* enlace en la lista de alarmas */
 	int numero_mutex;               	/*numero que dice cuantos mutex tiene abiertos*/
-	struct mutex *descriptores_mutex_sistema[NUM_MUT_PROC]; /*Array que almacena los descriptores de los mutex*/
+	unsigned long paginas_llenas;		/*bit i a 1 si la pagina i no tiene descriptores libres*/
+	pagina_desc *paginas_desc[MAX_PAG_DESC]; /*Paginas que almacenan los descriptores de los mutex*/
 } BCP;
 
 /*
@@ -57,7 +234,7 @@ typedef struct BCP_t {
  *
  */
 
-typedef struct{
+typedef struct lista_BCPs{
 	BCP *primero;
 	BCP *ultimo;
 } lista_BCPs;
@@ -75,11 +252,185 @@ BCP * p_proc_actual=NULL;
 
 BCP tabla_procs[MAX_PROC];
 
+/*
+ * Procesos creados desde el arranque, para dar a cada uno su encarnacion
+ */
+unsigned long encarnaciones=0;
+
 /*
  * Variable global que representa la cola de procesos listos
  */
 lista_BCPs lista_listos= {NULL, NULL};
 lista_BCPs lista_dormidos= {NULL, NULL};
+
+/*
+ * Procesos en una espera con plazo (lock_temporizado, esperar_eventos),
+ * enlazados por siguiente_temp. Tambien estan en la cola en la que esperan
+ */
+lista_BCPs lista_temporizados= {NULL, NULL};
+
+/*
+ * Procesos con una alarma programada, ordenados por proxima_alarma y
+ * enlazados por siguiente_alarma, y los que esperan a que venza
+ */
+BCP *alarmas=NULL;
+lista_BCPs lista_espera_alarma= {NULL, NULL};
+
+/*
+ * Mitades inferiores: los manejadores de reloj y terminal solo anotan lo
+ * que ha pasado y piden la interrupcion software. El trabajo que se
+ * puede aplazar lo hace int_sw a nivel 1, con el reloj permitido salvo
+ * en cada operacion sobre las listas. Lo mismo con el cambio de proceso
+ * al acabar la rodaja, que se hace al volver a modo usuario
+ */
+#define MI_TERMINAL 0		/* despertar a lectores e interesados */
+#define MI_RELOJ 1		/* dormidos, plazos, temporizadores y alarmas */
+#define MI_CONSOLA 2		/* volcar la consola */
+#define NUM_MITADES 3
+
+unsigned int mitades_pendientes=0;	/* bit n a 1 si hay que ejecutar la n */
+int necesita_replanificar=0;
+
+/*
+ * Variable global con el buffer circular de entrada del terminal
+ */
+struct {
+	char datos[TAM_BUF_TERM];
+	int primero;			/* posicion del caracter mas antiguo */
+	int num;			/* caracteres en el buffer */
+	unsigned long perdidos;		/* llegados con el buffer lleno */
+	lista_BCPs lectores;		/* procesos esperando caracteres */
+	struct interes *interesados;	/* conjuntos de eventos que lo vigilan */
+} terminal;
+
+/*
+ * Variable global con el buffer circular de salida de la consola. Los
+ * procesos dejan en el lineas completas y se vuelca con escribir_ker en
+ * pocas escrituras grandes
+ */
+struct {
+	char datos[TAM_CONSOLA];
+	int primero;			/* posicion del caracter mas antiguo */
+	int num;			/* caracteres en el buffer */
+	unsigned long desde;		/* tick en que dejo de estar vacio */
+	lista_BCPs escritores;		/* procesos esperando sitio */
+} consola;
+
+/*
+ * Variable global con las interrupciones de reloj desde el arranque
+ */
+unsigned long ticks_sistema=0;
+
+/*
+ * Tiempo del sistema en nanosegundos. ns_monotonico avanza ns_por_tick
+ * en cada tick y ns_por_tick se recalibra cada segundo con el reloj CMOS,
+ * que da milisegundos desde el 1-1-1970
+ */
+#define NS_TICK (1000000000L/TICK)	/* duracion nominal del tick */
+unsigned long long reloj_arranque;	/* reloj CMOS al arrancar */
+unsigned long long ns_monotonico=0;
+long ns_por_tick=NS_TICK;
+
+/*
+ * Medida de las interrupciones, en ciclos del procesador (en ns donde no
+ * hay contador de ciclos). Cada manejador instalado se mide de la entrada
+ * a la salida; si cambia de proceso por medio, hasta el cambio. Tambien
+ * se guardan las ventanas mas largas con el reloj inhibido abiertas con
+ * fijar_nivel_int, con la funcion y la linea que las abrio
+ */
+#define NUM_CUBOS_INT 16	/* histograma de duraciones */
+#define CUBO_MIN_INT 10		/* el primer cubo es de menos de 2^10 ciclos */
+#define NUM_VENTANAS 8
+#define MAX_NOM_FUNC 23
+
+/*
+ * Informe de estadisticas_int. Debe coincidir con el definido en
+ * usuario/include/servicios.h
+ */
+typedef struct{
+	unsigned long veces;
+	unsigned long long ciclos_total;
+	unsigned long long ciclos_max;
+	unsigned long histograma[NUM_CUBOS_INT]; /* el cubo i, de menos de 2^(10+i) */
+} est_vector;
+
+typedef struct{
+	char funcion[MAX_NOM_FUNC+1];
+	int linea;
+	unsigned long long ciclos;
+} est_ventana;
+
+typedef struct{
+	unsigned long long ciclos_por_tick;
+	est_vector vectores[NVECTORES];
+	est_ventana ventanas[NUM_VENTANAS]; /* de mayor a menor */
+} est_interrupciones;
+
+/* Manejador en curso, en la pila del kernel del proceso */
+struct medida{
+	int vector;
+	unsigned long long inicio;
+	unsigned long cortes;		/* cortes_medidas al empezar */
+	struct medida *anterior;	/* manejador al que interrumpio */
+};
+
+/*
+ * Traza de eventos del kernel. Cada punto de traza pertenece a una
+ * categoria y solo escribe si esta activada; los registros van a un
+ * anillo que, lleno, pisa los mas antiguos. Los tiempos son los de
+ * leer_ciclos
+ */
+#define TRAZA_PLANIF 0x01	/* cambios de proceso y espera sin listos */
+#define TRAZA_PROCESOS 0x02	/* creacion y fin de procesos */
+#define TRAZA_MUTEX 0x04	/* lock y unlock */
+#define TRAZA_DORMIR 0x08	/* dormir y despertar */
+#define TRAZA_INT 0x10		/* entrada y salida de manejadores */
+
+#define TR_SALE 0		/* dato1 proceso, dato2 su estado */
+#define TR_ENTRA 1		/* dato1 proceso */
+#define TR_INACTIVO 2		/* no hay listos */
+#define TR_ACTIVO 3
+#define TR_CREAR 4		/* dato1 proceso creado */
+#define TR_TERMINAR 5		/* dato1 proceso */
+#define TR_PIDE_LOCK 6		/* dato1 descriptor */
+#define TR_LOCK 7		/* dato1 descriptor, dato2 resultado */
+#define TR_UNLOCK 8		/* dato1 descriptor, dato2 resultado */
+#define TR_DORMIR 9		/* dato1 ticks */
+#define TR_DESPERTAR 10		/* dato1 proceso */
+#define TR_INT_ENTRA 11		/* dato1 vector */
+#define TR_INT_SALE 12		/* dato1 vector */
+
+#define TAM_TRAZA 4096		/* registros del anillo */
+
+/*
+ * Registro de la traza. Debe coincidir con el definido en
+ * usuario/include/servicios.h
+ */
+typedef struct{
+	unsigned long long ciclos;
+	short tipo;
+	short proc;			/* proceso actual, o -1 */
+	int dato1;
+	int dato2;
+} registro_traza;
+
+struct{
+	registro_traza regs[TAM_TRAZA];
+	int primero;
+	int num;
+	unsigned long perdidos;		/* pisados sin haberse leido */
+} traza;
+
+unsigned int categorias_traza=0;
+
+est_interrupciones medidas_int;
+struct medida *medidas_en_curso=NULL;
+unsigned long cortes_medidas=0;	/* cambios de proceso que las han cerrado */
+unsigned long long ciclos_arranque;
+unsigned long long inicio_inhibido=0;	/* 0 si el reloj no esta inhibido */
+const char *funcion_inhibido;
+int linea_inhibido;
+
 /*
  *
  * Definicin del tipo que corresponde con una entrada en la tabla de
@@ -92,23 +443,175 @@ typedef struct{
 
 //MUTEX
 
+/*
+ * Perfil de contencion de un mutex, en ticks de reloj. La espera se mide
+ * desde que el proceso entra en lista_bloqueados hasta que se le despierta
+ * y la retencion desde que se obtiene el mutex hasta que queda libre.
+ */
+typedef struct{
+	unsigned long adquisiciones;	//Veces que se ha obtenido libre
+	unsigned long contendidas;	//Adquisiciones que tuvieron que esperar
+	unsigned long espera_total;	//Ticks esperados en lista_bloqueados
+	unsigned long espera_max;	//Espera mas larga
+	unsigned long retencion_total;	//Ticks que ha estado cogido
+	unsigned long retencion_max;	//Retencion mas larga
+}perfil_mutex;
+
+/*
+ * Entrada del informe de estadisticas_mutex. Debe coincidir con la
+ * definida en usuario/include/servicios.h
+ */
+typedef struct{
+	char nombre[MAX_NOM_MUT+1];
+	perfil_mutex perfil;
+}est_mutex;
+
+/*
+ * Fuente vigilada por un conjunto de eventos. Esta a la vez en la lista
+ * de intereses de su conjunto, en la de interesados de su fuente y, si ha
+ * ocurrido el evento y no se ha recogido, en la de listos del conjunto
+ */
+typedef struct interes{
+	struct mutex *conjunto;		//Conjunto de eventos al que pertenece
+	int id;				//Identificador que devuelve anadir_evento
+	int tipo;			//Tipo de fuente (EV_TERMINAL, EV_MUTEX, ...)
+	struct mutex *fuente;		//Objeto vigilado, NULL si se ha destruido
+	unsigned long periodo;		//Ticks entre vencimientos del temporizador
+	unsigned long proximo;		//Tick del siguiente vencimiento
+	int listo;			//1 si esta en la lista de listos
+	struct interes *sig_conjunto;	//Siguiente del conjunto, o de los libres
+	struct interes *sig_fuente;	//Siguiente interesado en la misma fuente
+	struct interes *sig_listo;	//Siguiente en la lista de listos
+}interes;
+
+/*
+ * Evento listo que devuelve esperar_eventos. Debe coincidir con el
+ * definido en usuario/include/servicios.h
+ */
+typedef struct{
+	int id;
+	int tipo;
+}evento;
+
+/*
+ * Mensaje de una cola. Ocupa un hueco de la arena de la cola, con sitio
+ * para max_tam bytes de datos
+ */
+typedef struct msg_cola{
+	struct msg_cola *siguiente;	//Siguiente de su prioridad, o de los huecos libres
+	int tam;			//Bytes de datos
+	int prio;
+	char datos[];
+}msg_cola;
+
+/*
+ * Arena de una cola de mensajes: la cabecera con una lista por prioridad
+ * seguida de los huecos de los mensajes, reservada de una vez al crear la
+ * cola
+ */
+typedef struct arena_cola{
+	msg_cola *libres;		//Huecos sin mensaje
+	msg_cola *primero[NUM_PRIOS_MSG];	//Mensajes de cada prioridad, en orden de llegada
+	msg_cola *ultimo[NUM_PRIOS_MSG];
+}arena_cola;
+
+/*
+ * Mensaje que se pasa a enviar_lote y recibir_lote. Debe coincidir con
+ * el definido en usuario/include/servicios.h
+ */
+typedef struct{
+	char *buf;
+	int tam;
+	int prio;
+}mensaje;
+
+/*
+ * Memoria de objetos destruidos de tamao variable (arenas de colas,
+ * segmentos de memoria compartida), para reutilizarla. Cada bloque guarda
+ * al principio su tamao y el enlace con el siguiente
+ */
+typedef struct bloque_libre{
+	struct bloque_libre *siguiente;
+	int tam;
+}bloque_libre;
+
+bloque_libre *bloques_libres=NULL;
+
+/*
+ * Temporizadores de los conjuntos de eventos, ordenados por vencimiento
+ * y enlazados por sig_fuente
+ */
+interes *temporizadores_ev=NULL;
+
 typedef struct  mutex{
-	char nombre_mutex[MAX_NOM_MUT]; //Nombre del mute, el +1 es para el caracter de terminacin
+	char nombre_mutex[MAX_NOM_MUT+1]; //Nombre del mute, el +1 es para el caracter de terminacin
 	int valor;			  //Valor del mutex 0 o 1
 	int num_procesos;		//Nmero de procesos que estn usando el mutex
 	int tipo_mutex;			//Almacena si el mutex es o no recursivo
 	lista_BCPs lista_bloqueados; 	//Procesos bloqueados por el mutex
 	int BCP_id_lock;		//almacena el identificador del BCP que tiene el mutex bloqueado para que solo el pueda desbloquearlo
 	int contador_recursivo;		//almacena la cantidad de veces que se ha bloqueado un mutex recursivo
-	
+	struct mutex *siguiente;	//siguiente mutex de su lista en la tabla hash, o en la de libres
+	int clase;			//OBJ_MUTEX, OBJ_RWLOCK, ... OBJ_COLA u OBJ_MEMORIA
+	perfil_mutex perfil;		//Contencion medida desde su creacion
+	unsigned long inicio_lock;	//Tick en que se obtuvo por ultima vez
+	interes *interesados;		//Conjuntos de eventos que lo vigilan (mutex, tuberias y colas)
+	void *bloque;			//Memoria propia del objeto, o NULL
+	int tam_bloque;			//Bytes de esa memoria
+	cache_obj *cache_bloque;	//Cache de la que sale, o NULL si de bloques_libres
+	struct BCP_t *dueno;		//Proceso al que se carga el bloque
+	unsigned long encarnacion_dueno; //Para no descargarselo a otro que use su BCP
+	int tam_cargado;		//Bytes que se le han cargado, o 0
+	union{
+		struct{			//Estado de los lectores de un rwlock
+			lista_BCPs lista_lectores;	//Lectores bloqueados
+			int lectores;			//Lectores que tienen el rwlock
+			unsigned long mapa_lectores;	//bit i a 1 si el proceso i es lector
+			int escritores_esperando;	//Escritores en lista_bloqueados
+			int preferencia;		//PREF_LECTURA o PREF_ESCRITURA
+		}rw;
+		struct{			//Estado de una condicion
+			struct mutex *mutex_asociado;	//Mutex con el que se espera
+		}cond;
+		struct{			//Estado de un semaforo
+			int valor;			//Unidades disponibles
+		}sem;
+		struct{			//Estado de una barrera
+			int participantes;		//Procesos que se esperan en cada fase
+			int llegados;			//Procesos que han llegado en la fase actual
+			int generacion;			//Fases completadas
+		}barrera;
+		struct{			//Estado de un conjunto de eventos
+			interes *intereses;		//Fuentes vigiladas
+			interes *primero_listo;		//Eventos sin recoger, en orden
+			interes *ultimo_listo;
+			int num_intereses;
+			int siguiente_id;		//id del proximo interes
+		}ev;
+		struct{			//Estado de una tuberia. Los lectores esperan en lista_bloqueados
+			char *datos;			//Buffer circular de TAM_TUBERIA bytes, en bloque
+			int primero;			//Posicion del byte mas antiguo
+			int num;			//Bytes en el buffer
+			lista_BCPs escritores;		//Escritores esperando sitio
+		}tub;
+		struct{			//Estado de una cola de mensajes. Los receptores esperan en lista_bloqueados
+			arena_cola *arena;		//Mensajes, en bloque
+			unsigned int mapa;		//bit p a 1 si hay mensajes de prioridad p
+			int num;			//Mensajes en la cola
+			int max_msgs;
+			int max_tam;
+			lista_BCPs emisores;		//Emisores esperando sitio
+		}cola;
+		struct{			//Estado de un segmento de memoria compartida, que esta en bloque
+			int tam;			//Bytes pedidos al crearlo
+		}mem;
+	}u;
 	
 }mutex;
 
-
-
 struct lista_mutex{
   
-    mutex lista[NUM_MUT]; //lista con los mutex creados
+    mutex *hash[TAM_HASH_MUT]; //mutex creados, repartidos por nombre
     lista_BCPs bloqueados_en_espera; //Procesos que estan en espera para crear un mutex
     int contador_mutex; //Cuantos mutex hay creados
 
@@ -128,6 +631,55 @@ int abrir_mutex();
 int lock();
 int unlock();
 int cerrar_mutex();
+int crear_rwlock();
+int abrir_rwlock();
+int lock_lectura();
+int lock_escritura();
+int unlock_rw();
+int crear_condicion();
+int abrir_condicion();
+int esperar_condicion();
+int senalar();
+int difundir();
+int crear_semaforo();
+int abrir_semaforo();
+int sem_esperar();
+int sem_senalar();
+int crear_barrera();
+int abrir_barrera();
+int esperar_barrera();
+int estadisticas_mutex();
+int trylock();
+int lock_temporizado();
+int dormir_ms();
+int dormir_us();
+int obtener_tiempo();
+int alarma();
+int leer_alarma();
+int esperar_alarma();
+int leer_caracter();
+int leer();
+int crear_eventos();
+int anadir_evento();
+int esperar_eventos();
+int crear_tuberia();
+int abrir_tuberia();
+int escribir_tuberia();
+int leer_tuberia();
+int crear_cola();
+int abrir_cola();
+int enviar_lote();
+int recibir_lote();
+int crear_memoria_compartida();
+int abrir_memoria_compartida();
+int obtener_pila();
+int estadisticas_caches();
+int ampliar_monticulo();
+int limitar_memoria();
+int estadisticas_memoria();
+int estadisticas_int();
+int activar_traza();
+int leer_traza();
 
 /*
  * Variable global que contiene las rutinas que realizan cada llamada
@@ -141,7 +693,56 @@ servicio tabla_servicios[NSERVICIOS]={	{sis_crear_proceso},
 					{abrir_mutex},
 					{cerrar_mutex},
 					{lock},
-					{unlock}};
+					{unlock},
+					{crear_rwlock},
+					{abrir_rwlock},
+					{lock_lectura},
+					{lock_escritura},
+					{unlock_rw},
+					{crear_condicion},
+					{abrir_condicion},
+					{esperar_condicion},
+					{senalar},
+					{difundir},
+					{crear_semaforo},
+					{abrir_semaforo},
+					{sem_esperar},
+					{sem_senalar},
+					{crear_barrera},
+					{abrir_barrera},
+					{esperar_barrera},
+					{estadisticas_mutex},
+					{trylock},
+					{lock_temporizado},
+					{dormir_ms},
+					{dormir_us},
+					{obtener_tiempo},
+					{alarma},
+					{leer_alarma},
+					{leer_caracter},
+					{leer},
+					{crear_eventos},
+					{anadir_evento},
+					{esperar_eventos},
+					{crear_tuberia},
+					{abrir_tuberia},
+					{escribir_tuberia},
+					{leer_tuberia},
+					{crear_cola},
+					{abrir_cola},
+					{enviar_lote},
+					{recibir_lote},
+					{crear_memoria_compartida},
+					{abrir_memoria_compartida},
+					{obtener_pila},
+					{estadisticas_caches},
+					{ampliar_monticulo},
+					{limitar_memoria},
+					{estadisticas_memoria},
+					{estadisticas_int},
+					{activar_traza},
+					{leer_traza},
+					{esperar_alarma}};
 
 #endif /* _KERNEL_H */
 
@@ -19,7 +19,7 @@
 #define _LLAMSIS_H
 
 /* Numero de llamadas disponibles */
-#define NSERVICIOS 10
+#define NSERVICIOS 59
 
 #define CREAR_PROCESO 0
 #define TERMINAR_PROCESO 1
@@ -31,6 +31,55 @@
 #define CERRAR_MUTEX 7
 #define LOCK 8
 #define UNLOCK 9
+#define CREAR_RWLOCK 10
+#define ABRIR_RWLOCK 11
+#define LOCK_LECTURA 12
+#define LOCK_ESCRITURA 13
+#define UNLOCK_RW 14
+#define CREAR_CONDICION 15
+#define ABRIR_CONDICION 16
+#define ESPERAR_CONDICION 17
+#define SENALAR 18
+#define DIFUNDIR 19
+#define CREAR_SEMAFORO 20
+#define ABRIR_SEMAFORO 21
+#define SEM_ESPERAR 22
+#define SEM_SENALAR 23
+#define CREAR_BARRERA 24
+#define ABRIR_BARRERA 25
+#define ESPERAR_BARRERA 26
+#define ESTADISTICAS_MUTEX 27
+#define TRYLOCK 28
+#define LOCK_TEMPORIZADO 29
+#define DORMIR_MS 30
+#define DORMIR_US 31
+#define OBTENER_TIEMPO 32
+#define ALARMA 33
+#define LEER_ALARMA 34
+#define LEER_CARACTER 35
+#define LEER 36
+#define CREAR_EVENTOS 37
+#define ANADIR_EVENTO 38
+#define ESPERAR_EVENTOS 39
+#define CREAR_TUBERIA 40
+#define ABRIR_TUBERIA 41
+#define ESCRIBIR_TUBERIA 42
+#define LEER_TUBERIA 43
+#define CREAR_COLA 44
+#define ABRIR_COLA 45
+#define ENVIAR_LOTE 46
+#define RECIBIR_LOTE 47
+#define CREAR_MEMORIA_COMPARTIDA 48
+#define ABRIR_MEMORIA_COMPARTIDA 49
+#define OBTENER_PILA 50
+#define ESTADISTICAS_CACHES 51
+#define AMPLIAR_MONTICULO 52
+#define LIMITAR_MEMORIA 53
+#define ESTADISTICAS_MEMORIA 54
+#define ESTADISTICAS_INT 55
+#define ACTIVAR_TRAZA 56
+#define LEER_TRAZA 57
+#define ESPERAR_ALARMA 58
 
 #endif /* _LLAMSIS_H */
 
@@ -15,6 +15,37 @@
 
 #include "kernel.h"	/* Contiene defs. usadas por este modulo */
 static void int_sw();
+static void ejecutar_mitades();
+static void cortar_medidas();
+void cambio_pr(lista_BCPs *lis);
+int cerrar_mutex_aux(int mutexid,BCP* proc);
+void cerrar_mutex_proceso(BCP* proc);
+static int soltar_rwlock(mutex *rw,BCP *proc);
+static void sacar_de_mutex(mutex *mut, BCP *p, int motivo);
+static void vaciar_consola();
+static void pasar_linea(BCP *proc, int puede_bloquear);
+static void quitar_alarma(BCP *proc);
+static void liberar_monticulo(BCP *p);
+
+/*
+ * Los mensajes del kernel vacian antes la consola, para no adelantarse
+ * al texto que los procesos ya han escrito
+ */
+#define printk(...) (vaciar_consola(), printk(__VA_ARGS__))
+#define panico(mensaje) (vaciar_consola(), panico(mensaje))
+
+/*
+ * Cada cambio de nivel de interrupcion apunta donde se inhibe el reloj
+ */
+static int fijar_nivel_medido(int nivel, const char *funcion, int linea);
+#define fijar_nivel_int(nivel) fijar_nivel_medido(nivel, __func__, __LINE__)
+
+/*
+ * Punto de traza: con su categoria desactivada solo cuesta la comparacion
+ */
+static void trazar(int tipo, int dato1, int dato2);
+#define TRAZA(categoria, tipo, dato1, dato2) \
+	do { if (categorias_traza&(categoria)) trazar(tipo, dato1, dato2); } while (0)
 
 /*
  *
@@ -50,52 +81,304 @@ static int buscar_BCP_libre(){
 /*
  *
  * Funciones que facilitan el manejo de las listas de BCPs
- *	insertar_ultimo eliminar_primero eliminar_elem
+ *	insertar_ultimo insertar_antes eliminar_primero eliminar_elem
+ *	insertar_lista_ultimo
+ *	insertar_temporizado quitar_temporizado
+ *
+ * Las listas son doblemente enlazadas a traves de los campos siguiente y
+ * anterior del BCP, asi que todas las operaciones son O(1) salvo el
+ * empalme de listas en modo depuracion. lista_temporizados usa su propio
+ * enlace (siguiente_temp y anterior_temp), de modo que un proceso puede
+ * estar a la vez en ella y en otra lista. Compilando con -DDEPURAR_COLAS
+ * cada BCP apunta a la lista en la que esta y se comprueba en cada
+ * operacion.
  *
  * NOTA: PRIMERO SE DEBE LLAMAR A eliminar Y LUEGO A insertar
  */
 
+#ifdef DEPURAR_COLAS
+#define COMPROBAR_COLA(proc, lista) \
+	if ((proc)->cola!=(lista)) panico("BCP en una lista inesperada")
+#define FIJAR_COLA(proc, lista) ((proc)->cola=(lista))
+#else
+#define COMPROBAR_COLA(proc, lista)
+#define FIJAR_COLA(proc, lista)
+#endif
+
 /*
  * Inserta un BCP al final de la lista.
  */
 static void insertar_ultimo(lista_BCPs *lista, BCP * proc){
+	COMPROBAR_COLA(proc, NULL);
 	if (lista->primero==NULL)
 		lista->primero= proc;
 	else
 		lista->ultimo->siguiente=proc;
-	lista->ultimo= proc;
+	proc->anterior=lista->ultimo;
 	proc->siguiente=NULL;
+	lista->ultimo= proc;
+	FIJAR_COLA(proc, lista);
+}
+
+/*
+ * Inserta un BCP delante de otro de la lista, o al final si este es NULL.
+ */
+static void insertar_antes(lista_BCPs *lista, BCP * proc, BCP * sig){
+	if (sig==NULL) {
+		insertar_ultimo(lista, proc);
+		return;
+	}
+	COMPROBAR_COLA(proc, NULL);
+	COMPROBAR_COLA(sig, lista);
+	proc->siguiente=sig;
+	proc->anterior=sig->anterior;
+	if (sig->anterior)
+		sig->anterior->siguiente=proc;
+	else
+		lista->primero=proc;
+	sig->anterior=proc;
+	FIJAR_COLA(proc, lista);
+}
+
+/*
+ * Elimina un determinado BCP de la lista.
+ */
+static void eliminar_elem(lista_BCPs *lista, BCP * proc){
+	COMPROBAR_COLA(proc, lista);
+	if (proc->anterior)
+		proc->anterior->siguiente=proc->siguiente;
+	else
+		lista->primero=proc->siguiente;
+	if (proc->siguiente)
+		proc->siguiente->anterior=proc->anterior;
+	else
+		lista->ultimo=proc->anterior;
+	FIJAR_COLA(proc, NULL);
 }
 
 /*
  * Elimina el primer BCP de la lista.
  */
 static void eliminar_primero(lista_BCPs *lista){
+	eliminar_elem(lista, lista->primero);
+}
+
+/*
+ * Pasa todos los BCPs de la lista origen al final de la lista destino,
+ * dejando vacia la de origen.
+ */
+static void insertar_lista_ultimo(lista_BCPs *destino, lista_BCPs *origen){
+#ifdef DEPURAR_COLAS
+	BCP *proc;
+
+	for (proc=origen->primero; proc!=NULL; proc=proc->siguiente) {
+		COMPROBAR_COLA(proc, origen);
+		FIJAR_COLA(proc, destino);
+	}
+#endif
+	if (origen->primero==NULL)
+		return;
+	if (destino->primero==NULL)
+		destino->primero=origen->primero;
+	else
+		destino->ultimo->siguiente=origen->primero;
+	origen->primero->anterior=destino->ultimo;
+	destino->ultimo=origen->ultimo;
+	origen->primero=NULL;
+	origen->ultimo=NULL;
+}
 
-	if (lista->ultimo==lista->primero)
-		lista->ultimo=NULL;
-	lista->primero=lista->primero->siguiente;
+/*
+ * Apunta al proceso en lista_temporizados
+ */
+static void insertar_temporizado(BCP * proc){
+	proc->anterior_temp=lista_temporizados.ultimo;
+	proc->siguiente_temp=NULL;
+	if (lista_temporizados.primero==NULL)
+		lista_temporizados.primero=proc;
+	else
+		lista_temporizados.ultimo->siguiente_temp=proc;
+	lista_temporizados.ultimo=proc;
 }
 
 /*
- * Elimina un determinado BCP de la lista.
+ * Quita al proceso de lista_temporizados
  */
-static void eliminar_elem(lista_BCPs *lista, BCP * proc){
-	BCP *paux=lista->primero;
+static void quitar_temporizado(BCP * proc){
+#ifdef DEPURAR_COLAS
+	if (proc->cola_plazo==NULL)
+		panico("BCP fuera de lista_temporizados");
+#endif
+	proc->cola_plazo=NULL;
+	if (proc->anterior_temp)
+		proc->anterior_temp->siguiente_temp=proc->siguiente_temp;
+	else
+		lista_temporizados.primero=proc->siguiente_temp;
+	if (proc->siguiente_temp)
+		proc->siguiente_temp->anterior_temp=proc->anterior_temp;
+	else
+		lista_temporizados.ultimo=proc->anterior_temp;
+}
 
-	if (paux==proc){
-		eliminar_primero(lista);//printk("ID_PROCESO %d: \n",p_proc_actual->id);
-	  
+/*
+ *
+ * Funciones de las colas de espera:
+ *	esperar_en_cola despertar_proceso despertar_uno despertar_todos
+ *
+ * Cualquier lista_BCPs en la que se bloquean procesos es una cola de
+ * espera. Una espera exclusiva (la de quien va a quedarse con un recurso)
+ * se despierta de una en una; las no exclusivas se despiertan juntas.
+ * El proceso despertado recibe en motivo_desp por que se le despierta.
+ * Una espera con plazo apunta ademas al proceso en lista_temporizados, y
+ * al despertarle por cualquier motivo se le quita de ella.
+ *
+ */
+
+/*
+ * Bloquea al proceso actual en la cola y devuelve el motivo por el que
+ * le han despertado.
+ */
+static int esperar_en_cola(lista_BCPs *cola, int exclusiva){
+	p_proc_actual->espera_exclusiva=exclusiva;
+	p_proc_actual->motivo_desp=DESP_EVENTO;
+	cambio_pr(cola);
+	return p_proc_actual->motivo_desp;
+}
+
+/*
+ * Como esperar_en_cola, pero int_reloj le despierta con DESP_PLAZO si
+ * llega el tick plazo. Se llama con las interrupciones inhibidas
+ */
+static int esperar_con_plazo(lista_BCPs *cola, int exclusiva, unsigned long plazo){
+	p_proc_actual->plazo_espera=plazo;
+	p_proc_actual->cola_plazo=cola;
+	insertar_temporizado(p_proc_actual);
+	return esperar_en_cola(cola, exclusiva);
+}
+
+/*
+ * Saca un proceso de la cola en la que espera y lo pasa a listos.
+ */
+static void despertar_proceso(lista_BCPs *cola, BCP *proc, int motivo){
+	int nivel;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	eliminar_elem(cola, proc);
+	if(proc->cola_plazo!=NULL)
+		quitar_temporizado(proc);
+	proc->estado=LISTO;
+	proc->motivo_desp=motivo;
+	insertar_ultimo(&lista_listos, proc);
+	fijar_nivel_int(nivel);
+}
+
+/*
+ * Despierta a los primeros procesos de la cola hasta llegar al primero
+ * que espera en exclusiva, incluido. Devuelve cuantos ha despertado.
+ */
+static int despertar_uno(lista_BCPs *cola, int motivo){
+	BCP *proc;
+	int exclusiva=0, n=0;
+
+	while(!exclusiva && (proc=cola->primero)!=NULL){
+		exclusiva=proc->espera_exclusiva;
+		despertar_proceso(cola, proc, motivo);
+		n++;
 	}
-	else {
-		for ( ; ((paux) && (paux->siguiente!=proc));
-			paux=paux->siguiente);
-		if (paux) {
-		  
-			if (lista->ultimo==paux->siguiente)
-				lista->ultimo=paux;
-			paux->siguiente=paux->siguiente->siguiente;
-		}
+	return n;
+}
+
+/*
+ * Pasa de una vez a listos todos los procesos de la cola.
+ */
+static int despertar_todos(lista_BCPs *cola, int motivo){
+	BCP *proc;
+	int nivel, n=0;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	for(proc=cola->primero; proc!=NULL; proc=proc->siguiente){
+		if(proc->cola_plazo!=NULL)
+			quitar_temporizado(proc);
+		proc->estado=LISTO;
+		proc->motivo_desp=motivo;
+		n++;
+	}
+	insertar_lista_ultimo(&lista_listos, cola);
+	fijar_nivel_int(nivel);
+	return n;
+}
+
+/*
+ *
+ * Funciones de los conjuntos de eventos
+ *	marcar_listo notificar_interesados
+ *	insertar_temporizador_ev vencer_temporizadores_ev
+ *
+ * Cada fuente (el terminal, un mutex, un temporizador) guarda la lista
+ * de intereses que la vigilan, y sus rutinas de despertar marcan esos
+ * intereses como listos en el momento en que ocurre el evento, sin
+ * recorrer los conjuntos. El aviso es por flanco: un interes se entrega
+ * una vez y no vuelve a estar listo hasta el siguiente evento.
+ *
+ */
+
+/*
+ * Pone el interes al final de los listos de su conjunto, si no estaba ya,
+ * y despierta a quien espera en el. Se llama con las interrupciones
+ * inhibidas
+ */
+static void marcar_listo(interes *i){
+	mutex *conj=i->conjunto;
+
+	if(i->listo)
+		return;
+	i->listo=1;
+	i->sig_listo=NULL;
+	if(conj->u.ev.primero_listo==NULL)
+		conj->u.ev.primero_listo=i;
+	else
+		conj->u.ev.ultimo_listo->sig_listo=i;
+	conj->u.ev.ultimo_listo=i;
+	despertar_uno(&conj->lista_bloqueados, DESP_EVENTO);
+}
+
+/*
+ * Avisa a todos los intereses de una fuente de que ha ocurrido su evento
+ */
+static void notificar_interesados(interes *lista){
+	int nivel;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	for(; lista!=NULL; lista=lista->sig_fuente)
+		marcar_listo(lista);
+	fijar_nivel_int(nivel);
+}
+
+/*
+ * Inserta el temporizador en temporizadores_ev, ordenada por proximo
+ */
+static void insertar_temporizador_ev(interes *i){
+	interes **p;
+
+	for(p=&temporizadores_ev; *p!=NULL && (*p)->proximo<=i->proximo; p=&(*p)->sig_fuente)
+		;
+	i->sig_fuente=*p;
+	*p=i;
+}
+
+/*
+ * Marca los temporizadores vencidos y los vuelve a programar. Solo se
+ * mira la cabeza de la lista. Se llama desde int_reloj
+ */
+static void vencer_temporizadores_ev(){
+	interes *i;
+
+	while(temporizadores_ev!=NULL && temporizadores_ev->proximo<=ticks_sistema){
+		i=temporizadores_ev;
+		temporizadores_ev=i->sig_fuente;
+		marcar_listo(i);
+		i->proximo+=i->periodo;
+		insertar_temporizador_ev(i);
 	}
 }
 
@@ -113,9 +396,14 @@ static void espera_int(){
 
 	//printk("-> NO HAY LISTOS. ESPERA INT\n");
 
+	/* Aprovecha para volcar la consola */
+	vaciar_consola();
+
 	/* Baja al mnimo el nivel de interrupcin mientras espera */
 	nivel=fijar_nivel_int(NIVEL_1);
 	halt();
+	/* la int. SW sigue inhibida: el trabajo aplazado se hace aqui */
+	ejecutar_mitades();
 	fijar_nivel_int(nivel);
 }
 
@@ -123,8 +411,12 @@ static void espera_int(){
  * Funcin de planificacion que implementa un algoritmo FIFO.
  */
 static BCP * planificador(){
-	while (lista_listos.primero==NULL)
-		espera_int();		/* No hay nada que hacer */
+	if (lista_listos.primero==NULL) {
+		TRAZA(TRAZA_PLANIF, TR_INACTIVO, 0, 0);
+		while (lista_listos.primero==NULL)
+			espera_int();		/* No hay nada que hacer */
+		TRAZA(TRAZA_PLANIF, TR_ACTIVO, 0, 0);
+	}
 	return lista_listos.primero;
 }
 
@@ -137,18 +429,28 @@ static BCP * planificador(){
 static void liberar_proceso(){
 	BCP * p_proc_anterior;
 	
-	if(p_proc_actual->numero_mutex!=0)
+	TRAZA(TRAZA_PROCESOS, TR_TERMINAR, p_proc_actual->id, 0);
+	pasar_linea(p_proc_actual, 0); /* lo que quede de su ultima linea */
 	cerrar_mutex_proceso(p_proc_actual);
 	
 	liberar_imagen(p_proc_actual->info_mem); /* liberar mapa */
+	liberar_monticulo(p_proc_actual);
+	if (p_proc_actual->periodo_alarma) {
+		int nivel=fijar_nivel_int(NIVEL_3);
+		quitar_alarma(p_proc_actual);
+		fijar_nivel_int(nivel);
+	}
   
 	p_proc_actual->estado=TERMINADO;
 	
 	eliminar_primero(&lista_listos); /* proc. fuera de listos */
+	cortar_medidas();
+	TRAZA(TRAZA_PLANIF, TR_SALE, p_proc_actual->id, TERMINADO);
 
 	/* Realizar cambio de contexto */
 	p_proc_anterior=p_proc_actual;
 	p_proc_actual=planificador();
+	TRAZA(TRAZA_PLANIF, TR_ENTRA, p_proc_actual->id, 0);
 
 	printk("-> C.CONTEXTO POR FIN: de %d a %d\n",
 			p_proc_anterior->id, p_proc_actual->id);
@@ -166,8 +468,229 @@ static void liberar_proceso(){
  *	interrupciones del terminal: int_terminal
  *	llamadas al sistemas: llam_sis
  *	interrupciones SW: int_sw
+ *	mitades inferiores: programar_mitad pedir_replanificacion
+ *		ejecutar_mitades mitad_terminal mitad_reloj mitad_consola
+ *
+ */
+
+/*
+ * Anota una mitad inferior y pide la interrupcion software que la hara.
+ * Las que se piden varias veces antes de ejecutarse se hacen una vez
+ */
+static void programar_mitad(int n){
+	mitades_pendientes|=1<<n;
+	activar_int_SW();
+}
+
+static void pedir_replanificacion(){
+	necesita_replanificar=1;
+	activar_int_SW();
+}
+
+/*
+ * Medida de interrupciones: leer_ciclos anotar_duracion empezar_medida
+ *	terminar_medida cortar_medidas fijar_nivel_medido
+ */
+
+static unsigned long long leer_ciclos(){
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return leer_reloj_CMOS()*1000000ULL;
+#endif
+}
+
+static void anotar_duracion(int vector, unsigned long long ciclos){
+	est_vector *v=&medidas_int.vectores[vector];
+	int cubo;
+
+	v->veces++;
+	v->ciclos_total+=ciclos;
+	if (ciclos>v->ciclos_max)
+		v->ciclos_max=ciclos;
+	cubo=64-__builtin_clzll(ciclos|1)-CUBO_MIN_INT;
+	if (cubo<0)
+		cubo=0;
+	else if (cubo>=NUM_CUBOS_INT)
+		cubo=NUM_CUBOS_INT-1;
+	v->histograma[cubo]++;
+}
+
+static void empezar_medida(struct medida *m, int vector){
+	int nivel=(fijar_nivel_int)(NIVEL_3);
+
+	m->vector=vector;
+	m->cortes=cortes_medidas;
+	m->anterior=medidas_en_curso;
+	medidas_en_curso=m;
+	m->inicio=leer_ciclos();
+	TRAZA(TRAZA_INT, TR_INT_ENTRA, vector, 0);
+	(fijar_nivel_int)(nivel);
+}
+
+/* Si ha habido un cambio de proceso, ya la cerro cortar_medidas */
+static void terminar_medida(struct medida *m){
+	unsigned long long fin=leer_ciclos();
+	int nivel=(fijar_nivel_int)(NIVEL_3);
+
+	if (m->cortes==cortes_medidas) {
+		medidas_en_curso=m->anterior;
+		anotar_duracion(m->vector, fin-m->inicio);
+		TRAZA(TRAZA_INT, TR_INT_SALE, m->vector, 0);
+	}
+	(fijar_nivel_int)(nivel);
+}
+
+/*
+ * Cierra los manejadores en curso antes de un cambio de proceso, para
+ * no contar el tiempo que pase en otros
+ */
+static void cortar_medidas(){
+	unsigned long long fin=leer_ciclos();
+	int nivel=(fijar_nivel_int)(NIVEL_3);
+	struct medida *m;
+
+	for (m=medidas_en_curso; m!=NULL; m=m->anterior) {
+		anotar_duracion(m->vector, fin-m->inicio);
+		TRAZA(TRAZA_INT, TR_INT_SALE, m->vector, 0);
+	}
+	medidas_en_curso=NULL;
+	cortes_medidas++;
+	(fijar_nivel_int)(nivel);
+}
+
+/*
+ * Mete la ventana en la tabla de las mas largas, ordenada de mayor a
+ * menor, si le corresponde
+ */
+static void anotar_ventana(const char *funcion, int linea, unsigned long long ciclos){
+	est_ventana *v=medidas_int.ventanas;
+	int i;
+
+	if (ciclos<=v[NUM_VENTANAS-1].ciclos)
+		return;
+	for (i=NUM_VENTANAS-1; i>0 && v[i-1].ciclos<ciclos; i--)
+		v[i]=v[i-1];
+	strncpy(v[i].funcion, funcion, MAX_NOM_FUNC);
+	v[i].funcion[MAX_NOM_FUNC]='\0';
+	v[i].linea=linea;
+	v[i].ciclos=ciclos;
+}
+
+/*
+ * fijar_nivel_int del HAL, apuntando cuando se inhibe el reloj y cuanto
+ * tiempo pasa hasta que se vuelve a permitir
+ */
+static int fijar_nivel_medido(int nivel, const char *funcion, int linea){
+	int anterior=(fijar_nivel_int)(nivel);
+
+	if (nivel>=NIVEL_3 && anterior<NIVEL_3) {
+		inicio_inhibido=leer_ciclos();
+		funcion_inhibido=funcion;
+		linea_inhibido=linea;
+	}
+	else if (nivel<NIVEL_3 && anterior>=NIVEL_3 && inicio_inhibido) {
+		anotar_ventana(funcion_inhibido, linea_inhibido,
+			       leer_ciclos()-inicio_inhibido);
+		inicio_inhibido=0;
+	}
+	return anterior;
+}
+
+/*
+ * Manejadores que se instalan: cada uno mide al que envuelve
+ */
+#define MANEJADOR_MEDIDO(manejador, vector) \
+static void manejador##_medido(){ \
+	struct medida m; \
+	empezar_medida(&m, vector); \
+	manejador(); \
+	terminar_medida(&m); \
+}
+
+/*
+ * Devuelve en *e las medidas de las interrupciones y, si reiniciar no es
+ * 0, las pone a cero
+ */
+int estadisticas_int(){
+	est_interrupciones *e=(est_interrupciones *)leer_registro(1);
+	int reiniciar=(int)leer_registro(2);
+	int nivel;
+
+	if (e==NULL)
+		return -1;
+	nivel=fijar_nivel_int(NIVEL_3);
+	*e=medidas_int;
+	if (reiniciar)
+		memset(&medidas_int, 0, sizeof(medidas_int));
+	fijar_nivel_int(nivel);
+	if (ticks_sistema>0)
+		e->ciclos_por_tick=(leer_ciclos()-ciclos_arranque)/ticks_sistema;
+	return 0;
+}
+
+/*
  *
+ * Traza de eventos: trazar activar_traza leer_traza
+ *
+ */
+
+static void trazar(int tipo, int dato1, int dato2){
+	registro_traza *r;
+	int nivel=(fijar_nivel_int)(NIVEL_3);
+
+	if (traza.num==TAM_TRAZA) {
+		traza.primero=(traza.primero+1)%TAM_TRAZA;
+		traza.num--;
+		traza.perdidos++;
+	}
+	r=&traza.regs[(traza.primero+traza.num)%TAM_TRAZA];
+	traza.num++;
+	r->ciclos=leer_ciclos();
+	r->tipo=tipo;
+	r->proc=p_proc_actual ? p_proc_actual->id : -1;
+	r->dato1=dato1;
+	r->dato2=dato2;
+	(fijar_nivel_int)(nivel);
+}
+
+/*
+ * Fija las categorias de la traza que estan activadas y devuelve las que
+ * lo estaban
+ */
+int activar_traza(){
+	unsigned int anteriores=categorias_traza;
+
+	categorias_traza=(unsigned int)leer_registro(1);
+	return anteriores;
+}
+
+/*
+ * Saca de la traza hasta n registros, los mas antiguos, y los copia en
+ * el vector del usuario. Deja en *perdidos, si no es nulo, los que se han
+ * pisado desde la ultima lectura. Devuelve cuantos ha copiado
  */
+int leer_traza(){
+	registro_traza *v=(registro_traza *)leer_registro(1);
+	int n=(int)leer_registro(2);
+	unsigned long *perdidos=(unsigned long *)leer_registro(3);
+	int i, nivel;
+
+	if (v==NULL || n<0)
+		return -1;
+	nivel=fijar_nivel_int(NIVEL_3);
+	for (i=0; i<n && traza.num>0; i++) {
+		v[i]=traza.regs[traza.primero];
+		traza.primero=(traza.primero+1)%TAM_TRAZA;
+		traza.num--;
+	}
+	if (perdidos) {
+		*perdidos=traza.perdidos;
+		traza.perdidos=0;
+	}
+	fijar_nivel_int(nivel);
+	return i;
+}
 
 /*
  * Tratamiento de excepciones aritmeticas
@@ -208,65 +731,191 @@ static void int_terminal(){
 	char car;
 
 	car = leer_puerto(DIR_TERMINAL);
-	printk("-> TRATANDO INT. DE TERMINAL %c\n", car);
+	//printk("-> TRATANDO INT. DE TERMINAL %c\n", car);
 
+	// con el buffer lleno el caracter se pierde
+	if (terminal.num==TAM_BUF_TERM) {
+		terminal.perdidos++;
+		return;
+	}
+	terminal.datos[(terminal.primero+terminal.num)%TAM_BUF_TERM]=car;
+	terminal.num++;
+	programar_mitad(MI_TERMINAL);
         return;
 }
 
 /*
- * Tratamiento de interrupciones de reloj
+ * Avanza el tiempo monotonico en cada tick. Una vez por segundo se
+ * compara con el reloj CMOS y se ajusta la duracion del tick para
+ * absorber la diferencia a lo largo del segundo siguiente (si se pierden
+ * interrupciones el tick se alarga). El ajuste se limita para que el
+ * tiempo nunca retroceda ni de saltos.
+ */
+static void avanzar_reloj(){
+	long long desfase;
+	long ajuste;
+
+	ns_monotonico+=ns_por_tick;
+	if(ticks_sistema%TICK!=0)
+		return;
+	desfase=(long long)((leer_reloj_CMOS()-reloj_arranque)*1000000ULL)-(long long)ns_monotonico;
+	ajuste=desfase/TICK;
+	if(ajuste>NS_TICK/2)
+		ajuste=NS_TICK/2;
+	else if(ajuste<-NS_TICK/2)
+		ajuste=-NS_TICK/2;
+	ns_por_tick=NS_TICK+ajuste;
+}
+
+/*
+ * Alarmas periodicas: insertar_alarma quitar_alarma vencer_alarmas
+ *
+ * En cada tick se cuentan las alarmas vencidas de cada proceso. No se
+ * llama a ningun manejador: el HAL no deja desviar la vuelta a modo
+ * usuario, y ejecutarlo desde el kernel haria que sus fallos tiraran el
+ * sistema. El proceso consulta la cuenta con leer_alarma, o se bloquea
+ * hasta la siguiente con esperar_alarma. Los procesos con alarma estan en
+ * una lista ordenada por vencimiento, asi que cada tick solo mira su
+ * cabeza. Se llaman con las interrupciones inhibidas.
+ */
+static void insertar_alarma(BCP *proc){
+	BCP **p;
+
+	for(p=&alarmas; *p!=NULL && (*p)->proxima_alarma<=proc->proxima_alarma; p=&(*p)->siguiente_alarma)
+		;
+	proc->siguiente_alarma=*p;
+	*p=proc;
+}
+
+static void quitar_alarma(BCP *proc){
+	BCP **p;
+
+	for(p=&alarmas; *p!=NULL; p=&(*p)->siguiente_alarma)
+		if(*p==proc){
+			*p=proc->siguiente_alarma;
+			return;
+		}
+}
+
+static void vencer_alarmas(){
+	BCP * p;
+
+	while(alarmas!=NULL && alarmas->proxima_alarma<=ticks_sistema){
+		p=alarmas;
+		alarmas=p->siguiente_alarma;
+		do {
+			p->alarmas_vencidas++;
+			p->proxima_alarma+=p->periodo_alarma;
+		} while(p->proxima_alarma<=ticks_sistema);
+		if(p->esperando_alarma){
+			p->esperando_alarma=0;
+			despertar_proceso(&lista_espera_alarma, p, DESP_EVENTO);
+		}
+		insertar_alarma(p);
+	}
+}
+
+/*
+ * Tratamiento de interrupciones de reloj. Solo lleva el tiempo y la
+ * rodaja; lo demas lo hace su mitad inferior
  */
 static void int_reloj(){
 
 	//printk("-> TRATANDO INT. DE RELOJ\n");
-	if(p_proc_actual->estado == LISTO){
-	  if(p_proc_actual->rodaja != 0){
-	    p_proc_actual->rodaja =  p_proc_actual->rodaja-1;
-	    printf("rodaja %d\n",  p_proc_actual->rodaja);
-	  
-	    if(p_proc_actual->rodaja == 0){
-	      int_sw(); 
-	    }
-	  }else{
-	      p_proc_actual->rodaja = 3;
-	  }
+	ticks_sistema++;
+	avanzar_reloj();
+	if(p_proc_actual->estado == LISTO && p_proc_actual->rodaja > 0 &&
+	   --p_proc_actual->rodaja == 0)
+		pedir_replanificacion();
+	programar_mitad(MI_RELOJ);
+	// la consola se vuelca si se llena o si el texto lleva tiempo en ella
+	if(consola.num >= MARCA_CONSOLA ||
+	   (consola.num > 0 && ticks_sistema - consola.desde >= PLAZO_CONSOLA))
+		programar_mitad(MI_CONSOLA);
+        return;
+}
+
+/*
+ * Despierta a un lector por cada caracter que espera, y avisa a los
+ * conjuntos de eventos que vigilan el terminal
+ */
+static void mitad_terminal(){
+	int n, nivel;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	for(n=terminal.num; n>0 && terminal.lectores.primero!=NULL; n--)
+		despertar_uno(&terminal.lectores, DESP_EVENTO);
+	fijar_nivel_int(nivel);
+	notificar_interesados(terminal.interesados);
+}
+
+/*
+ * Trabajo de los ticks que han pasado desde la ultima vez
+ */
+static void mitad_reloj(){
+	BCP * p;
+	BCP * p_sig;
+	int nivel;
+
+	// control de proceso: la lista de dormidos esta ordenada por plazo,
+	// asi que solo hay que mirar su cabeza. Los que vencen en el mismo
+	// tick se despiertan en la misma pasada
+	for(;;){
+		nivel=fijar_nivel_int(NIVEL_3);
+		p=lista_dormidos.primero;
+		if(p==NULL || p->fin_dormir > ticks_sistema){
+			fijar_nivel_int(nivel);
+			break;
+		}
+		// se pasa de la lista de dormidos a la de listos
+		despertar_proceso(&lista_dormidos, p, DESP_PLAZO);
+		fijar_nivel_int(nivel);
+		TRAZA(TRAZA_DORMIR, TR_DESPERTAR, p->id, 0);
 	}
-	// control de proceso
-	if(lista_dormidos.primero != NULL){
-		// proceso con el que se operar
-		BCP * p_dormido;
-		// proceso siguiente de la lista
-		BCP * p_dormido_sig;
-		// variable que almacenar en el nivel de interrupcin
-		int nivel;
-		// se accede mediante el struct al primer elemento de la lista	
-		p_dormido = lista_dormidos.primero;
-		// bucle que procesa la lista de procesos dormidos
-		while(p_dormido != NULL){
-			// se reduce el tiempo
-			p_dormido->tiempo_dormir--;
-			// se guarda el siguiente proceso
-			p_dormido_sig = p_dormido->siguiente;
-			// en el caso del que tiempo acabe
-			if(p_dormido->tiempo_dormir <= 0){
-				// se desbloquea el proceso
-				p_dormido->estado = LISTO;
-				// se notifica la interrupcin de reloj
-				nivel=fijar_nivel_int(NIVEL_3);
-				// se notifica por pantalla que el proceso ha despertado
-				printk("proceso %d despierta y se va a la lista de listos \n", p_dormido->id);
-				// se elimina el proceso de la lista de dormidos
-				eliminar_elem(&lista_dormidos, p_dormido);
-				// se inserta en la lista de listos
-				insertar_ultimo(&lista_listos, p_dormido);
-				// se termina la interrupcin del reloj
-				fijar_nivel_int(nivel);			
+	// plazos vencidos de lock_temporizado y esperar_eventos
+	nivel=fijar_nivel_int(NIVEL_3);
+	for(p = lista_temporizados.primero; p != NULL; p = p_sig){
+		p_sig = p->siguiente_temp;
+		if(ticks_sistema >= p->plazo_espera){
+			if(p->mutex_espera != NULL){
+				p->espera_mutex = 0;
+				sacar_de_mutex(p->mutex_espera, p, DESP_PLAZO);
 			}
-			// se pasa al siguiente proceso
-			p_dormido = p_dormido_sig;
+			else
+				despertar_proceso(p->cola_plazo, p, DESP_PLAZO);
 		}
 	}
-        return;
+	vencer_temporizadores_ev();
+	vencer_alarmas();
+	fijar_nivel_int(nivel);
+}
+
+static void mitad_consola(){
+	vaciar_consola();
+}
+
+static void (*tabla_mitades[NUM_MITADES])()={mitad_terminal, mitad_reloj,
+					     mitad_consola};
+
+/*
+ * Ejecuta, en orden, las mitades inferiores pendientes, incluidas las que
+ * se pidan mientras tanto
+ */
+static void ejecutar_mitades(){
+	unsigned int pendientes;
+	int n, nivel;
+
+	for(;;){
+		nivel=fijar_nivel_int(NIVEL_3);
+		pendientes=mitades_pendientes;
+		mitades_pendientes=0;
+		fijar_nivel_int(nivel);
+		if(pendientes==0)
+			return;
+		for(n=0; n<NUM_MITADES; n++)
+			if(pendientes&(1<<n))
+				tabla_mitades[n]();
+	}
 }
 
 /*
@@ -281,44 +930,273 @@ static void tratar_llamsis(){
 	else
 		res=-18;		/* servicio no existente */
 	escribir_registro(0,res);
+	// la replanificacion pedida durante la llamada se hace al salir de ella
+	if(necesita_replanificar)
+		cambio_pr(&lista_listos);
 	return;
 }
 
 /*
- * Tratamiento de interrupciuones software
+ * Tratamiento de interrupciuones software: hace las mitades inferiores y,
+ * si interrumpio al proceso en modo usuario, la replanificacion pendiente.
+ * Si interrumpio al kernel, el cambio espera a que acabe la llamada en
+ * curso
  */
 static void int_sw(){
-	printk("-> TRATANDO INT. SW\n");
-	cambio_pr(&lista_listos);
-}
-
-void iniciar_lista_mutex_sistema(){  
-  lista_mutex.contador_mutex=0;
-  lista_mutex.bloqueados_en_espera.primero=NULL;
-  lista_mutex.bloqueados_en_espera.ultimo=NULL;
-  
-  for(int i=0;i<NUM_MUT;i++){
-    lista_mutex.lista[i].num_procesos=0;
-  }  
+	ejecutar_mitades();
+	if(!viene_de_modo_usuario())
+		return;
+	if(necesita_replanificar){
+		cambio_pr(&lista_listos);
+	}
 }
 
-void iniciar_lista_mutex(BCP *proc){  
-  proc->numero_mutex=0;  
-  for(int i=0;i<NUM_MUT_PROC;i++){    
-   proc->descriptores_mutex_sistema[i]=NULL;    
-  }  
-  
+/*
+ * Reserva memoria para las estructuras dinamicas del kernel. Se obtiene
+ * del HAL y no se devuelve nunca: los bloques se reciclan mediante las
+ * listas de libres de cada estructura.
+ */
+static void *reservar_memoria_ker(int tam){
+	return crear_pila(tam);
 }
 
 /*
- *
- * Funcion auxiliar que crea un proceso reservando sus recursos.
+ * Memoria de los objetos que la necesitan. Se saca de bloques_libres el
+ * primer bloque de al menos tam bytes, o se pide uno nuevo, y en tam se
+ * devuelve lo que mide en realidad. El tamao se redondea a 8 bytes y
+ * nunca baja del de bloque_libre, que se escribe en el al devolverlo. Si
+ * al bloque le sobra sitio para otro, el resto se queda en la lista
+ */
+static void *reservar_bloque(int *tam){
+	bloque_libre **p, *b, *resto;
+
+	*tam=(*tam+7)&~7;
+	if(*tam<(int)sizeof(bloque_libre))
+		*tam=sizeof(bloque_libre);
+	for(p=&bloques_libres; *p!=NULL; p=&(*p)->siguiente){
+		if((*p)->tam>=*tam){
+			b=*p;
+			if(b->tam-*tam>=(int)sizeof(bloque_libre)){
+				resto=(bloque_libre*)((char*)b+*tam);
+				resto->tam=b->tam-*tam;
+				resto->siguiente=b->siguiente;
+				*p=resto;
+			}
+			else{
+				*p=b->siguiente;
+				*tam=b->tam;
+			}
+			return b;
+		}
+	}
+	return reservar_memoria_ker(*tam);
+}
+
+static void devolver_bloque(void *dir, int tam){
+	bloque_libre *b=dir;
+
+	b->tam=tam;
+	b->siguiente=bloques_libres;
+	bloques_libres=b;
+}
+
+/*
+ *
+ * Contabilidad de la memoria de cada proceso:
+ *	cargar_memoria cargar_objeto descargar_objeto
+ *
+ */
+
+/*
+ * Carga tam bytes del tipo dado al proceso, o se los descuenta si tam es
+ * negativo. Falla si la carga le hace pasar de su limite
+ */
+static int cargar_memoria(BCP *p, int tipo, long tam){
+	if (tam>0 && p->mem_en_uso+tam>p->limite_memoria) {
+		p->fallos_memoria++;
+		return -1;
+	}
+	p->memoria[tipo]+=tam;
+	p->mem_en_uso+=tam;
+	if (p->mem_en_uso>p->mem_max)
+		p->mem_max=p->mem_en_uso;
+	return 0;
+}
+
+/*
+ * Apunta en el objeto que su bloque, ya cargado al proceso actual, es
+ * suyo, para descargarselo al destruirlo aunque lo destruya otro
+ */
+static void cargar_objeto(mutex *mut, int tam){
+	mut->dueno=p_proc_actual;
+	mut->encarnacion_dueno=p_proc_actual->encarnacion;
+	mut->tam_cargado=tam;
+}
+
+/* Si su dueo ya ha terminado no hay nada que descargar */
+static void descargar_objeto(mutex *mut){
+	if (mut->tam_cargado &&
+	    mut->dueno->encarnacion==mut->encarnacion_dueno &&
+	    mut->dueno->estado!=TERMINADO)
+		cargar_memoria(mut->dueno, MEM_IPC, -(long)mut->tam_cargado);
+	mut->tam_cargado=0;
+}
+
+/*
+ *
+ * Caches de objetos del kernel:
+ *	iniciar_cache reservar_obj liberar_obj
+ *
+ * El enlace de la lista de libres va detras de cada objeto, asi que no
+ * pisa el estado que deja el constructor.
+ *
+ */
+
+#define ENLACE_OBJ(c, obj) (*(void **)((char *)(obj)+(((c)->tam+7)&~7)))
+
+static void iniciar_cache(cache_obj *c, char *nombre, int tam,
+			  unsigned long max_objetos, void (*constructor)(void *)){
+	strncpy(c->nombre, nombre, MAX_NOM_CACHE);
+	c->nombre[MAX_NOM_CACHE]='\0';
+	c->tam=tam;
+	c->tam_hueco=(((tam+7)&~7)+sizeof(void *)+TAM_LINEA_CACHE-1)&~(TAM_LINEA_CACHE-1);
+	c->por_bloque=TAM_BLOQUE_CACHE/c->tam_hueco;
+	if (c->por_bloque==0)
+		c->por_bloque=1;
+	c->max_objetos=max_objetos;
+	c->constructor=constructor;
+	c->libres=NULL;
+	c->objetos=c->bloques=c->en_uso=c->max_en_uso=c->reservas=0;
+	c->siguiente=caches;
+	caches=c;
+}
+
+/*
+ * Pide al HAL un bloque, lo alinea a linea de cache y lo parte en
+ * objetos construidos. Falla si la cache ha llegado a su tope
+ */
+static int crecer_cache(cache_obj *c){
+	unsigned long n=c->por_bloque;
+	unsigned long i;
+	char *bloque;
+
+	if (c->max_objetos && c->objetos+n>c->max_objetos)
+		n=c->max_objetos-c->objetos;
+	if (n==0)
+		return -1;
+	if ((bloque=reservar_memoria_ker(n*c->tam_hueco+TAM_LINEA_CACHE-1))==NULL)
+		return -1;
+	bloque=(char *)(((unsigned long)bloque+TAM_LINEA_CACHE-1)&~(unsigned long)(TAM_LINEA_CACHE-1));
+	for (i=0; i<n; i++, bloque+=c->tam_hueco) {
+		if (c->constructor)
+			c->constructor(bloque);
+		ENLACE_OBJ(c, bloque)=c->libres;
+		c->libres=bloque;
+	}
+	c->objetos+=n;
+	c->bloques++;
+	return 0;
+}
+
+/*
+ * Saca un objeto construido de la cache, o NULL si no quedan y no puede
+ * crecer
+ */
+static void *reservar_obj(cache_obj *c){
+	void *obj;
+
+	if (c->libres==NULL && crecer_cache(c)<0)
+		return NULL;
+	obj=c->libres;
+	c->libres=ENLACE_OBJ(c, obj);
+	c->reservas++;
+	if (++c->en_uso>c->max_en_uso)
+		c->max_en_uso=c->en_uso;
+	return obj;
+}
+
+static void liberar_obj(cache_obj *c, void *obj){
+	ENLACE_OBJ(c, obj)=c->libres;
+	c->libres=obj;
+	c->en_uso--;
+}
+
+//Estado construido de los objetos de cada cache
+static void construir_mutex(void *obj){
+	mutex *mut=obj;
+
+	mut->num_procesos=0;
+	mut->lista_bloqueados.primero=NULL;
+	mut->lista_bloqueados.ultimo=NULL;
+	mut->interesados=NULL;
+	mut->bloque=NULL;
+}
+
+static void construir_pagina(void *obj){
+	((pagina_desc *)obj)->mapa=0;
+}
+
+static void iniciar_caches(){
+	iniciar_cache(&cache_mutex, "mutex", sizeof(mutex), MAX_MUT, construir_mutex);
+	iniciar_cache(&cache_paginas, "paginas", sizeof(pagina_desc), 0, construir_pagina);
+	iniciar_cache(&cache_intereses, "intereses", sizeof(interes), 0, NULL);
+	iniciar_cache(&cache_tuberias, "tuberias", TAM_TUBERIA, 0, NULL);
+}
+
+/*
+ * Copia en el vector del usuario el estado de hasta n caches y devuelve
+ * cuantas ha copiado
+ */
+int estadisticas_caches(){
+	est_cache *tabla=(est_cache *)leer_registro(1);
+	int n=(int)leer_registro(2);
+	cache_obj *c;
+	int i;
+
+	if (tabla==NULL || n<=0)
+		return -1;
+	for (c=caches, i=0; c!=NULL && i<n; c=c->siguiente, i++) {
+		strcpy(tabla[i].nombre, c->nombre);
+		tabla[i].tam=c->tam;
+		tabla[i].objetos=c->objetos;
+		tabla[i].bloques=c->bloques;
+		tabla[i].en_uso=c->en_uso;
+		tabla[i].max_en_uso=c->max_en_uso;
+		tabla[i].reservas=c->reservas;
+	}
+	return i;
+}
+
+void iniciar_lista_mutex_sistema(){  
+  lista_mutex.contador_mutex=0;
+  lista_mutex.bloqueados_en_espera.primero=NULL;
+  lista_mutex.bloqueados_en_espera.ultimo=NULL;
+  
+  for(int i=0;i<TAM_HASH_MUT;i++){
+    lista_mutex.hash[i]=NULL;
+  }  
+}
+
+void iniciar_lista_mutex(BCP *proc){  
+  proc->numero_mutex=0;  
+  proc->paginas_llenas=0;
+  for(int i=0;i<MAX_PAG_DESC;i++){    
+   proc->paginas_desc[i]=NULL;    
+  }  
+  
+}
+
+/*
+ *
+ * Funcion auxiliar que crea un proceso reservando sus recursos.
  * Usada por llamada crear_proceso.
  *
  */
 
 
 
+static int heredar_tuberias(BCP *padre, BCP *hijo);
+
 static int crear_tarea(char *prog){
 	void * imagen, *pc_inicial;
 	int error=0;
@@ -332,6 +1210,14 @@ static int crear_tarea(char *prog){
 
 	/* A rellenar el BCP ... */
 	p_proc=&(tabla_procs[proc]);
+	/* hereda el limite de memoria de quien lo crea */
+	p_proc->encarnacion=++encarnaciones;
+	memset(p_proc->memoria, 0, sizeof(p_proc->memoria));
+	p_proc->mem_en_uso=p_proc->mem_max=p_proc->fallos_memoria=0;
+	p_proc->limite_memoria=p_proc_actual ? p_proc_actual->limite_memoria :
+		LIMITE_MEMORIA;
+	if (cargar_memoria(p_proc, MEM_PILA, TAM_PILA)<0)
+		return -1;
 	/* crea la imagen de memoria leyendo ejecutable */	
 	imagen=crear_imagen(prog, &pc_inicial);	
 	
@@ -343,13 +1229,28 @@ static int crear_tarea(char *prog){
 			&(p_proc->contexto_regs));
 		p_proc->id=proc;
 		iniciar_lista_mutex(p_proc); //Inicio la lista de mutex del proceso
+		if(p_proc_actual!=NULL && heredar_tuberias(p_proc_actual, p_proc)<0){
+			liberar_pila(p_proc->pila);
+			liberar_imagen(imagen);
+			return -1;
+		}
 		p_proc->estado=LISTO;
 		// rodaja del round robin
 		p_proc->rodaja=TICKS_POR_RODAJA;		
+		p_proc->espera_mutex=0;
+		p_proc->mutex_espera=NULL;
+		p_proc->cola_plazo=NULL;
+		p_proc->long_linea=0;
+		p_proc->num_trozos=0;
+		p_proc->tam_monticulo=0;
+		p_proc->periodo_alarma=0;
+		p_proc->alarmas_vencidas=0;
+		p_proc->esperando_alarma=0;
 		/* lo inserta al final de cola de listos */
 		nivel=fijar_nivel_int(NIVEL_3);
 		insertar_ultimo(&lista_listos, p_proc);
 		fijar_nivel_int(nivel);
+		TRAZA(TRAZA_PROCESOS, TR_CREAR, proc, 0);
 		error= 0;
 	}
 	else
@@ -365,6 +1266,66 @@ static int crear_tarea(char *prog){
  *
  */
 
+/*
+ *
+ * Consola de salida: pasar_linea vaciar_consola
+ *
+ * sis_escribir no escribe en pantalla: arma las lineas en el BCP y pasa
+ * cada una entera al buffer de la consola, para que las de distintos
+ * procesos no se mezclen. El buffer se vuelca cuando el sistema no tiene
+ * nada que hacer, desde int_reloj si se llena o el texto lleva
+ * PLAZO_CONSOLA ticks en el, y antes de cada mensaje del kernel. Solo se
+ * bloquea el escritor que no cabe.
+ *
+ */
+
+/*
+ * Vuelca el buffer de la consola, como mucho en dos escrituras, y
+ * despierta a los que esperaban sitio
+ */
+static void vaciar_consola(){
+	int nivel, trozo;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	if (consola.num>0) {
+		trozo=TAM_CONSOLA-consola.primero;
+		if (trozo>consola.num)
+			trozo=consola.num;
+		escribir_ker(consola.datos+consola.primero, trozo);
+		if (trozo<consola.num)
+			escribir_ker(consola.datos, consola.num-trozo);
+		consola.primero=0;
+		consola.num=0;
+		despertar_todos(&consola.escritores, DESP_EVENTO);
+	}
+	fijar_nivel_int(nivel);
+}
+
+/*
+ * Pasa al buffer de la consola la linea que tiene armada el proceso. Si
+ * no cabe, el proceso actual espera sitio cuando puede bloquearse; si no,
+ * se vacia la consola en el momento
+ */
+static void pasar_linea(BCP *proc, int puede_bloquear){
+	int nivel, i, fin;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	while (TAM_CONSOLA-consola.num<proc->long_linea) {
+		if (puede_bloquear)
+			esperar_en_cola(&consola.escritores, 1);
+		else
+			vaciar_consola();
+	}
+	if (consola.num==0)
+		consola.desde=ticks_sistema;
+	fin=consola.primero+consola.num;
+	for (i=0; i<proc->long_linea; i++)
+		consola.datos[(fin+i)%TAM_CONSOLA]=proc->linea[i];
+	consola.num+=proc->long_linea;
+	proc->long_linea=0;
+	fijar_nivel_int(nivel);
+}
+
 /*
  * Tratamiento de llamada al sistema crear_proceso. Llama a la
  * funcion auxiliar crear_tarea sis_terminar_proceso
@@ -387,12 +1348,16 @@ int sis_crear_proceso(){
 int sis_escribir()
 {
 	char *texto;
-	unsigned int longi;
+	unsigned int longi, i;
 
 	texto=(char *)leer_registro(1);
 	longi=(unsigned int)leer_registro(2);
 
-	escribir_ker(texto, longi);
+	for (i=0; i<longi; i++) {
+		p_proc_actual->linea[p_proc_actual->long_linea++]=texto[i];
+		if (texto[i]=='\n' || p_proc_actual->long_linea==TAM_LINEA_CONS)
+			pasar_linea(p_proc_actual, 1);
+	}
 	return 0;
 }
 
@@ -411,6 +1376,13 @@ int sis_terminar_proceso(){
 
 
 
+MANEJADOR_MEDIDO(exc_arit, EXC_ARITM)
+MANEJADOR_MEDIDO(exc_mem, EXC_MEM)
+MANEJADOR_MEDIDO(int_reloj, INT_RELOJ)
+MANEJADOR_MEDIDO(int_terminal, INT_TERMINAL)
+MANEJADOR_MEDIDO(tratar_llamsis, LLAM_SIS)
+MANEJADOR_MEDIDO(int_sw, INT_SW)
+
 /*
  *
  * Rutina de inicializacin invocada en arranque
@@ -419,18 +1391,21 @@ int sis_terminar_proceso(){
 int main(){
 	/* se llega con las interrupciones prohibidas */
 
-	instal_man_int(EXC_ARITM, exc_arit); 
-	instal_man_int(EXC_MEM, exc_mem); 
-	instal_man_int(INT_RELOJ, int_reloj); 
-	instal_man_int(INT_TERMINAL, int_terminal); 
-	instal_man_int(LLAM_SIS, tratar_llamsis); 
-	instal_man_int(INT_SW, int_sw); 
+	instal_man_int(EXC_ARITM, exc_arit_medido); 
+	instal_man_int(EXC_MEM, exc_mem_medido); 
+	instal_man_int(INT_RELOJ, int_reloj_medido); 
+	instal_man_int(INT_TERMINAL, int_terminal_medido); 
+	instal_man_int(LLAM_SIS, tratar_llamsis_medido); 
+	instal_man_int(INT_SW, int_sw_medido); 
 
 	iniciar_cont_int();		/* inicia cont. interr. */
+	ciclos_arranque=leer_ciclos();
+	reloj_arranque=leer_reloj_CMOS(); /* origen del tiempo monotonico */
 	iniciar_cont_reloj(TICK);	/* fija frecuencia del reloj */
 	iniciar_cont_teclado();		/* inici cont. teclado */
 
 	iniciar_tabla_proc();		/* inicia BCPs de tabla de procesos */
+	iniciar_caches();
 	iniciar_lista_mutex_sistema();
 	/* crea proceso inicial */
 	if (crear_tarea((void *)"init")<0)
@@ -438,39 +1413,321 @@ int main(){
 	
 	/* activa proceso inicial */
 	p_proc_actual=planificador();
+	TRAZA(TRAZA_PLANIF, TR_ENTRA, p_proc_actual->id, 0);
 	cambio_contexto(NULL, &(p_proc_actual->contexto_regs));
 	panico("S.O. reactivado inesperadamente");
 	return 0;
 }
+/*
+ * Devuelve en *t el tiempo pedido: TIEMPO_TICKS, TIEMPO_MONOTONICO (ns
+ * desde el arranque) o TIEMPO_REAL (ns desde el 1-1-1970)
+ */
+int obtener_tiempo(){
+	int tipo=(int)leer_registro(1);
+	unsigned long long *t=(unsigned long long *)leer_registro(2);
+
+	if(t==NULL)
+		return -1;
+	switch(tipo){
+	case TIEMPO_TICKS:
+		*t=ticks_sistema;
+		break;
+	case TIEMPO_MONOTONICO:
+		*t=ns_monotonico;
+		break;
+	case TIEMPO_REAL:
+		*t=reloj_arranque*1000000ULL+ns_monotonico;
+		break;
+	default:
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Programa una alarma periodica de periodo_ms milisegundos, redondeados
+ * hacia arriba a ticks. Un periodo 0 la cancela
+ */
+int alarma(){
+	unsigned long ms=(unsigned int)leer_registro(1);
+	int nivel;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	if(p_proc_actual->periodo_alarma)
+		quitar_alarma(p_proc_actual);
+	p_proc_actual->alarmas_vencidas=0;
+	if(ms==0){
+		p_proc_actual->periodo_alarma=0;
+	}
+	else {
+		p_proc_actual->periodo_alarma=(ms*TICK+999)/1000;
+		p_proc_actual->proxima_alarma=ticks_sistema+p_proc_actual->periodo_alarma;
+		insertar_alarma(p_proc_actual);
+	}
+	fijar_nivel_int(nivel);
+	return 0;
+}
+
+/*
+ * Devuelve cuantas alarmas han vencido desde la ultima consulta y pone
+ * la cuenta a cero
+ */
+int leer_alarma(){
+	int vencidas, nivel;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	vencidas=p_proc_actual->alarmas_vencidas;
+	p_proc_actual->alarmas_vencidas=0;
+	fijar_nivel_int(nivel);
+	return vencidas;
+}
+
+/*
+ * Como leer_alarma, pero si no ha vencido ninguna se bloquea hasta la
+ * siguiente. Devuelve las vencidas (mas de una indica que se han
+ * perdido periodos), o -1 si no hay alarma programada
+ */
+int esperar_alarma(){
+	int vencidas, nivel;
+
+	if(p_proc_actual->periodo_alarma==0)
+		return -1;
+	nivel=fijar_nivel_int(NIVEL_3);
+	if(p_proc_actual->alarmas_vencidas==0){
+		p_proc_actual->esperando_alarma=1;
+		esperar_en_cola(&lista_espera_alarma, 0);
+	}
+	vencidas=p_proc_actual->alarmas_vencidas;
+	p_proc_actual->alarmas_vencidas=0;
+	fijar_nivel_int(nivel);
+	return vencidas;
+}
+
+/*
+ *
+ * Llamadas de lectura del terminal: leer_caracter leer
+ *
+ * int_terminal deja los caracteres en un buffer circular de TAM_BUF_TERM
+ * posiciones y despierta al primer lector bloqueado. Cada lector se lleva
+ * lo que hay (hasta lo que pida); si deja algo, despierta al siguiente.
+ *
+ */
+
+/*
+ * Espera a que haya caracteres y copia hasta n en buf. Se llama y
+ * vuelve con la interrupcion de terminal inhibida
+ */
+static int sacar_terminal(char *buf, int n){
+	int i;
+
+	while (terminal.num==0)
+		esperar_en_cola(&terminal.lectores, 1);
+	for (i=0; i<n && terminal.num>0; i++) {
+		buf[i]=terminal.datos[terminal.primero];
+		terminal.primero=(terminal.primero+1)%TAM_BUF_TERM;
+		terminal.num--;
+	}
+	if (terminal.num>0)
+		despertar_uno(&terminal.lectores, DESP_EVENTO);
+	return i;
+}
+
+int leer_caracter(){
+	char car;
+	int nivel;
+
+	pasar_linea(p_proc_actual, 1); /* que se vea lo que se pregunta */
+	nivel=fijar_nivel_int(NIVEL_2);
+	sacar_terminal(&car, 1);
+	fijar_nivel_int(nivel);
+	return car;
+}
+
+int leer(){
+	char *buf=(char *)leer_registro(1);
+	int n=(int)leer_registro(2);
+	int nivel, leidos;
+
+	if (buf==NULL || n<=0)
+		return -1;
+	pasar_linea(p_proc_actual, 1);
+	nivel=fijar_nivel_int(NIVEL_2);
+	leidos=sacar_terminal(buf, n);
+	fijar_nivel_int(nivel);
+	return leidos;
+}
+
+/*
+ * Deja en *base la direccion de la pila del proceso y, si no es nulo, en
+ * *encarnacion la que lo distingue de otros que hayan usado su BCP.
+ * Devuelve su identificador
+ */
+int obtener_pila(){
+	void **base=(void **)leer_registro(1);
+	unsigned long *encarnacion=(unsigned long *)leer_registro(2);
+
+	if (base==NULL)
+		return -1;
+	*base=p_proc_actual->pila;
+	if (encarnacion!=NULL)
+		*encarnacion=p_proc_actual->encarnacion;
+	return p_proc_actual->id;
+}
+
+/*
+ * Mueve el final del monticulo del proceso incremento bytes, como sbrk,
+ * y deja en *dir el final anterior. El monticulo se reserva en trozos de
+ * TROZO_MONTICULO bytes, con reservar_bloque, segun va creciendo: si lo
+ * que se pide no cabe en el ultimo trozo se empieza otro, que no tiene
+ * por que seguirle, y *dir es su principio. Al bajar no se sale del
+ * ultimo trozo. Lo que crece se entrega a cero y se carga al limite de
+ * memoria del proceso
+ */
+int ampliar_monticulo(){
+	int incremento=(int)leer_registro(1);
+	void **dir=(void **)leer_registro(2);
+	BCP *p=p_proc_actual;
+	int tam;
+	char *trozo;
+
+	if (dir==NULL)
+		return -1;
+	if (incremento>TROZO_MONTICULO || p->tam_monticulo+incremento<0)
+		return -7;
+	if (incremento>0 &&
+	    (p->num_trozos==0 || p->tam_monticulo+incremento>TROZO_MONTICULO)) {
+		if (p->num_trozos==MAX_TROZOS_MONTICULO ||
+		    cargar_memoria(p, MEM_MONTICULO, incremento)<0)
+			return -7;
+		tam=TROZO_MONTICULO;
+		if ((trozo=reservar_bloque(&tam))==NULL) {
+			cargar_memoria(p, MEM_MONTICULO, -incremento);
+			return -7;
+		}
+		p->trozos_monticulo[p->num_trozos]=trozo;
+		p->tam_trozos[p->num_trozos++]=tam;
+		p->tam_monticulo=0;
+	}
+	else if (p->num_trozos==0) {
+		*dir=NULL;
+		return 0;
+	}
+	else if (cargar_memoria(p, MEM_MONTICULO, incremento)<0)
+		return -7;
+	trozo=p->trozos_monticulo[p->num_trozos-1];
+	*dir=trozo+p->tam_monticulo;
+	if (incremento>0)
+		memset(trozo+p->tam_monticulo, 0, incremento);
+	p->tam_monticulo+=incremento;
+	return 0;
+}
+
+/* Devuelve los trozos del monticulo, enteros y sin recorrerlos */
+static void liberar_monticulo(BCP *p){
+	int i;
+
+	for (i=0; i<p->num_trozos; i++)
+		devolver_bloque(p->trozos_monticulo[i], p->tam_trozos[i]);
+	p->num_trozos=0;
+}
+
+/*
+ * Baja el limite de memoria del proceso, que heredan los que cree. No se
+ * puede subir
+ */
+int limitar_memoria(){
+	unsigned long limite=(unsigned long)leer_registro(1);
+
+	if (limite>p_proc_actual->limite_memoria)
+		return -1;
+	p_proc_actual->limite_memoria=limite;
+	return 0;
+}
+
+/*
+ * Copia en *e la memoria cargada al proceso pid, o al que llama si pid
+ * es negativo
+ */
+int estadisticas_memoria(){
+	int pid=(int)leer_registro(1);
+	est_memoria *e=(est_memoria *)leer_registro(2);
+	BCP *p=p_proc_actual;
+
+	if (e==NULL)
+		return -1;
+	if (pid>=0) {
+		if (pid>=MAX_PROC || tabla_procs[pid].estado==NO_USADA)
+			return -1;
+		p=&tabla_procs[pid];
+	}
+	e->en_uso=p->mem_en_uso;
+	e->max_en_uso=p->mem_max;
+	e->limite=p->limite_memoria;
+	e->pila=p->memoria[MEM_PILA];
+	e->monticulo=p->memoria[MEM_MONTICULO];
+	e->ipc=p->memoria[MEM_IPC];
+	e->fallos=p->fallos_memoria;
+	return 0;
+}
+
 int obtener_id_pr(){
 	printk("El identificador es: %d \n",p_proc_actual->id);
 	return p_proc_actual->id;
 }
 
+/*
+ * Inserta al proceso en la lista de dormidos, que se mantiene ordenada
+ * por fin_dormir. Se busca desde el final porque lo normal es que el
+ * ultimo en dormirse sea el ultimo en despertar
+ */
+static void insertar_dormido(BCP * proc){
+	BCP * sig=NULL;
+	BCP * p;
+
+	for(p=lista_dormidos.ultimo; p!=NULL && p->fin_dormir>proc->fin_dormir; p=p->anterior)
+		sig=p;
+	insertar_antes(&lista_dormidos, proc, sig);
+}
+
+/*
+ * Parte comun de dormir, dormir_ms y dormir_us. La resolucion es la del
+ * reloj: el proceso despierta en la interrupcion del tick indicado
+ */
+static int dormir_ticks(unsigned long ticks){
+	if(ticks==0)
+		return 0;
+	// le damos a su atributo el tick en que despierta
+	p_proc_actual->fin_dormir = ticks_sistema + ticks;
+	// notificamos por pantalla que el proceso es bloqueado
+	printk ("proceso actual %d dormido por %lu ticks\n", p_proc_actual->id, ticks);
+	TRAZA(TRAZA_DORMIR, TR_DORMIR, (int)ticks, 0);
+	// bloqueamos al proceso en la lista de dormidos
+	esperar_en_cola(&lista_dormidos, 0);
+	return 0;
+}
+
 int dormir (){
 	// variable que contendr los segundos que duerme
 	unsigned int segundos;
-	// variable que abarcar el nivel de interrupcin
-	int nivel;
-	// proceso anterior
-	BCP * p_proc_anterior;
 	// obtenemos el nmero de segundos que duerme
 	segundos=(unsigned int)leer_registro(1);	
-	// le damos a su atributo el tiempo
-	p_proc_actual->tiempo_dormir = segundos*TICK;		
-	// bloqueamos al proceso	
-	// notificamos por pantalla que el proceso es bloqueado
-	printk ("proceso actual %d dormido por %u ticks\n", p_proc_actual->id, p_proc_actual->tiempo_dormir);
-	// el proceso anterior copia los atributos del actual
-	cambio_pr(&lista_dormidos);
-	return 0;	
+	return dormir_ticks((unsigned long)segundos*TICK);
 }
 
- 
-
+/*
+ * dormir_ms y dormir_us redondean hacia arriba a ticks de reloj
+ */
+int dormir_ms (){
+	unsigned long ms=(unsigned int)leer_registro(1);
 
+	return dormir_ticks((ms*TICK+999)/1000);
+}
 
+int dormir_us (){
+	unsigned long us=(unsigned int)leer_registro(1);
 
+	return dormir_ticks((us*TICK+999999)/1000000);
+}
 
 void cambio_pr(lista_BCPs *lis){ //Mtodo que cambia de proceso y lo coloca en la lista correspondiente, ya sea en la de bloqueados de un mutex o cualquier otra
 	BCP * p_proc_anterior;
@@ -482,6 +1739,10 @@ void cambio_pr(lista_BCPs *lis){ //M
 
 	//El proceso no sigue. Si hubiera alguna replanificacin pendiente
 	//hay que desactivarla puesto que ya se est haciendo 
+	necesita_replanificar=0;
+	cortar_medidas();
+	TRAZA(TRAZA_PLANIF, TR_SALE, p_proc_anterior->id,
+	      lis==&lista_listos ? LISTO : BLOQUEADO);
 
 
 	//Se usa eliminar_elem ya que proc. actual no tiene porque ser el 1
@@ -489,7 +1750,9 @@ void cambio_pr(lista_BCPs *lis){ //M
 
 	/* Si se ha especificado una lista destino para el BCP, se inserta.
 	   Si lista_destino != &lista_listos -> c.contexto voluntario */
-	if (lis)
+	if (lis==&lista_dormidos)
+		insertar_dormido(p_proc_anterior); /* ordenada por plazo */
+	else if (lis)
 		insertar_ultimo(lis, p_proc_anterior);
 		if (lis != &lista_listos)
 			/* C. contexto voluntario -> estado=BLOQUEADO */
@@ -498,6 +1761,7 @@ void cambio_pr(lista_BCPs *lis){ //M
 
 	p_proc_actual=planificador();
 	p_proc_actual->rodaja=TICKS_POR_RODAJA;
+	TRAZA(TRAZA_PLANIF, TR_ENTRA, p_proc_actual->id, 0);
 	/* Si el proceso ya ha terminado, no se salva y se libera la pila */
 	if (p_proc_anterior->estado==TERMINADO) {
 		liberar_pila(p_proc_anterior->pila);
@@ -511,159 +1775,344 @@ void cambio_pr(lista_BCPs *lis){ //M
 	
 }
 
+static int hash_nombre(char *nombre){ //Lista de la tabla hash que corresponde a un nombre
+  unsigned int h=0;
+  
+  for(int i=0;i<MAX_NOM_MUT && nombre[i]!='\0';i++){
+    h=h*31+(unsigned char)nombre[i];
+  }
+  return h%TAM_HASH_MUT;
+}
+
 mutex* buscar_mutex(char *nombre){ //Buscar un mutex por nombre
+  mutex *mut;
 
- for(int i=0;i<NUM_MUT;i++){	
-  if(lista_mutex.contador_mutex>=0){    
-    if(strncmp(lista_mutex.lista[i].nombre_mutex,nombre,MAX_NOM_MUT)==0){
-      return &lista_mutex.lista[i];      
+  for(mut=lista_mutex.hash[hash_nombre(nombre)];mut!=NULL;mut=mut->siguiente){
+    if(strncmp(mut->nombre_mutex,nombre,MAX_NOM_MUT)==0){
+      return mut;
     }
-}
-}
-return NULL;
+  }
+  return NULL;
 }
 
 
 int nombre_valido(char *nombre){//comprueba si el nombre del mutex es correcto y no se produce excepcin por ser demasiado largo
   if(strlen(nombre)<=MAX_NOM_MUT){
-    return 0;} 
+    return 0;}
+  return -1;
 }
 
-int buscar_descriptor_BCP(BCP *proc){  
-  for(int i=0;i<NUM_MUT_PROC;i++){    
-    if(proc->descriptores_mutex_sistema[i]==NULL){    
-    return i;    
-  }  
+/*
+ * Devuelve una pagina de descriptores vacia. Las de procesos terminados
+ * vuelven a la cache con el mapa a 0
+ */
+static pagina_desc *reservar_pagina_desc(){
+  return reservar_obj(&cache_paginas);
 }
-  return -6;
+
+int buscar_descriptor_BCP(BCP *proc){ //Busca el primer descriptor libre usando los mapas de bits
+  int pag;
+  
+  pag=__builtin_ctzl(~proc->paginas_llenas);
+  if(pag>=MAX_PAG_DESC){
+    return -6;
+  }
+  if(proc->paginas_desc[pag]==NULL){
+    if((proc->paginas_desc[pag]=reservar_pagina_desc())==NULL){
+      return -6;
+    }
+  }
+  return pag*DESC_POR_PAGINA+__builtin_ctzl(~proc->paginas_desc[pag]->mapa);
 }
 
+//Asocia un mutex a un descriptor obtenido con buscar_descriptor_BCP
+static void fijar_descriptor_BCP(BCP *proc,int descriptor,mutex *mut){
+  pagina_desc *pag=proc->paginas_desc[descriptor/DESC_POR_PAGINA];
+  int i=descriptor%DESC_POR_PAGINA;
+  
+  pag->desc[i]=mut;
+  pag->mapa|=1UL<<i;
+  if(pag->mapa==~0UL){
+    proc->paginas_llenas|=1UL<<(descriptor/DESC_POR_PAGINA);
+  }
+  proc->numero_mutex++;
+}
 
-mutex *buscar_mutex_sistema(){ //Busca un mutex que est vaco sin usarse
+static void quitar_descriptor_BCP(BCP *proc,int descriptor){
+  pagina_desc *pag=proc->paginas_desc[descriptor/DESC_POR_PAGINA];
   
- for(int i=0;i<NUM_MUT;i++){
- if(lista_mutex.lista[i].num_procesos<=0){
- return &lista_mutex.lista[i];  //Devuelvo la referencia con el & porque es justo ese mutex de la lista el que quiero
-}  
+  pag->mapa&=~(1UL<<(descriptor%DESC_POR_PAGINA));
+  proc->paginas_llenas&=~(1UL<<(descriptor/DESC_POR_PAGINA));
+  proc->numero_mutex--;
+}
 
-} 
-  return NULL; //no hay ninguno libre
+mutex *obtener_mutex_BCP(BCP *proc,unsigned int descriptor){ //Mutex asociado a un descriptor o NULL si no es valido
+  pagina_desc *pag;
+  int i=descriptor%DESC_POR_PAGINA;
+  
+  if(descriptor>=MAX_MUT_PROC){
+    return NULL;
+  }
+  pag=proc->paginas_desc[descriptor/DESC_POR_PAGINA];
+  if(pag==NULL || !(pag->mapa&(1UL<<i))){
+    return NULL;
+  }
+  return pag->desc[i];
 }
 
-int crear_mutex(){ 
-	char *nombre;
-	int tipo,nivel;
-	int descriptor;
-	int bucle;
-	mutex* mut;  
-	
-	nombre=(char*)leer_registro(1);
-	tipo=(int)leer_registro(2);
-	
+//Como obtener_mutex_BCP, pero solo si el objeto es de la clase pedida
+static mutex *obtener_objeto_BCP(BCP *proc,unsigned int descriptor,int clase){
+  mutex *mut=obtener_mutex_BCP(proc,descriptor);
+  
+  if(mut!=NULL && mut->clase!=clase){
+    return NULL;
+  }
+  return mut;
+}
+
+mutex *buscar_mutex_sistema(){ //Saca un mutex libre de su cache, o NULL si ha llegado al tope
+  return reservar_obj(&cache_mutex);
+}
+
+//Da de alta un mutex en la tabla hash. Los anonimos no se meten en ella
+static void insertar_mutex_sistema(mutex *mut){
+  int h=hash_nombre(mut->nombre_mutex);
+  
+  if(mut->nombre_mutex[0]!='\0'){
+    mut->siguiente=lista_mutex.hash[h];
+    lista_mutex.hash[h]=mut;
+  }
+  lista_mutex.contador_mutex++;
+}
+
+static void liberar_conjunto(mutex *conj);
+static void olvidar_fuente(mutex *mut);
+
+//Quita un mutex de la tabla hash y lo devuelve a su cache
+static void liberar_mutex_sistema(mutex *mut){
+  mutex **p=&lista_mutex.hash[hash_nombre(mut->nombre_mutex)];
+  
+  if(mut->clase==OBJ_EVENTOS){
+    liberar_conjunto(mut);
+  }
+  descargar_objeto(mut);
+  if(mut->cache_bloque!=NULL){
+    liberar_obj(mut->cache_bloque,mut->bloque);
+  }
+  else if(mut->bloque!=NULL){
+    devolver_bloque(mut->bloque,mut->tam_bloque);
+  }
+  mut->bloque=NULL;
+  olvidar_fuente(mut);
+  if(mut->nombre_mutex[0]!='\0'){
+    while(*p!=mut){
+      p=&(*p)->siguiente;
+    }
+    *p=mut->siguiente;
+  }
+  liberar_obj(&cache_mutex,mut);
+  lista_mutex.contador_mutex--;
+}
 
+//Entrega un mutex libre del pool al primero que espera uno, si lo hay
+static void entregar_mutex_libre(){
+  if(lista_mutex.bloqueados_en_espera.primero!=NULL){
+    lista_mutex.bloqueados_en_espera.primero->entrega=buscar_mutex_sistema();
+    despertar_uno(&lista_mutex.bloqueados_en_espera, DESP_EVENTO);
+  }
+}
+
+/*
+ * Parte comun de la creacion de objetos con nombre (mutex, rwlock, ...).
+ * Todos comparten el pool, la tabla de nombres y los descriptores del
+ * proceso. Con nombre NULL el objeto es anonimo: no entra en la tabla de
+ * nombres y solo se usa con el descriptor devuelto. Devuelve el
+ * descriptor o un error.
+ */
+static int crear_objeto(char *nombre, int clase, mutex **pmut){ 
+	int descriptor;
+	mutex* mut;  
 	
-      if(p_proc_actual->numero_mutex==NUM_MUT_PROC){
+      if(buscar_descriptor_BCP(p_proc_actual)<0){ //Compruebo que le queden descriptores
 	
 	return -7;
 	
-	
-	
       }
-      if(nombre_valido(nombre)!=0){
+      if(nombre!=NULL && nombre_valido(nombre)!=0){
 	  
     return -2;
 	}
 	
-	if(buscar_mutex(nombre)!=NULL){ //Compruebo que no exista un mutex con ese nombre
+	if(nombre!=NULL && buscar_mutex(nombre)!=NULL){ //Compruebo que no exista un mutex con ese nombre
 	  
       return -3;
 	  
 	}
 	
-	
-	
-	  
-	 
-	    
-	  while(lista_mutex.contador_mutex==NUM_MUT){
-	    
-	  
+	  //Solo se espera si el pool ha llegado al tope del sistema y no puede
+	  //crecer. Quien libere un mutex nos lo entrega al despertarnos
+	  if((mut=buscar_mutex_sistema())==NULL){
 	    
-	   
-	     bucle=1;
-	       
-	  cambio_pr(&lista_mutex.bloqueados_en_espera);
-	     
-	     
-	   
-	     
-	   
+	  esperar_en_cola(&lista_mutex.bloqueados_en_espera, 1);
 	    
+	  mut=p_proc_actual->entrega;
 	    
-	  }
-	  
-	
-	  
-	      
-	  if( bucle ==1){
-	    //Volvemos a comprobar el nombre por salir del bucle anterior
-	  if(buscar_mutex(nombre)!=0){ //Compruebo que no exista un mutex con ese nombre
+	    //Volvemos a comprobar el nombre por haber estado bloqueados
+	  if(nombre!=NULL && buscar_mutex(nombre)!=0){ //Compruebo que no exista un mutex con ese nombre
 	  
      // printk("Ya existe un mutex con ese nombre");
+      liberar_obj(&cache_mutex,mut);
+      entregar_mutex_libre(); //el siguiente que espera no debe perderlo
       return -4;
 	  
-	  
 	} 
 	    
 	  }
       
-	  
       descriptor=buscar_descriptor_BCP(p_proc_actual);
-	  
-      p_proc_actual->numero_mutex++;
-      
-      mut=buscar_mutex_sistema();
       
-      p_proc_actual->descriptores_mutex_sistema[descriptor]=mut;
+      fijar_descriptor_BCP(p_proc_actual,descriptor,mut);
       
+      mut->clase=clase;
       
-   
-      
-      mut->num_procesos++;
-      
-      mut->tipo_mutex=tipo;
+      mut->num_procesos=1;
       
       mut->valor=MUTEX_DESBLOQUEADO;
       
+      mut->BCP_id_lock=-1;
       
-      strcpy(mut->nombre_mutex, nombre);
-      
+      strcpy(mut->nombre_mutex, nombre!=NULL ? nombre : "");
       
+      mut->cache_bloque=NULL;
       
-      mut->lista_bloqueados.primero=NULL;
-      
-      mut->lista_bloqueados.ultimo=NULL;
-      
-      lista_mutex.contador_mutex++;
+      mut->tam_cargado=0;
       
+      memset(&mut->perfil,0,sizeof(mut->perfil));
       
+      insertar_mutex_sistema(mut);
       
+      *pmut=mut;
       return descriptor;
 }
 
-
-int lock(){  
- BCP*p_proc_anterior;
-	int bloqueado;
-	int nivel;
-	mutex*mut;
-	unsigned int mutexid = (unsigned int)leer_registro(1);
+int crear_mutex(){ 
+	char *nombre;
+	int tipo;
+	int descriptor;
+	mutex* mut;  
 	
+	nombre=(char*)leer_registro(1);
+	tipo=(int)leer_registro(2);
 	
-	if(p_proc_actual->descriptores_mutex_sistema[mutexid]==NULL){
-	  return -12;
+	if((descriptor=crear_objeto(nombre,OBJ_MUTEX,&mut))<0){
+	  return descriptor;
+	}
+	mut->tipo_mutex=tipo;
+	return descriptor;
+}
+
+
+/*
+ * Mete al proceso en la cola del mutex anotando cuando empieza a esperar.
+ * Se llama con las interrupciones inhibidas
+ */
+static void encolar_en_mutex(mutex *mut, BCP *p){
+	p->inicio_espera=ticks_sistema;
+	p->espera_mutex=1;
+	insertar_ultimo(&mut->lista_bloqueados,p);
+}
+
+/*
+ * Saca al proceso de la cola del mutex y lo pasa a listos anotando lo
+ * que ha esperado
+ */
+static void sacar_de_mutex(mutex *mut, BCP *p, int motivo){
+	unsigned long espera;
+	int nivel;
+
+	espera=ticks_sistema-p->inicio_espera;
+	mut->perfil.espera_total+=espera;
+	if(espera>mut->perfil.espera_max){
+		mut->perfil.espera_max=espera;
+	}
+	nivel=fijar_nivel_int(NIVEL_3);
+	p->mutex_espera=NULL;
+	despertar_proceso(&mut->lista_bloqueados,p,motivo);
+	fijar_nivel_int(nivel);
+}
+
+//Despierta al primero que espera el mutex, si lo hay
+static void despertar_mutex(mutex *mut){
+	if(mut->lista_bloqueados.primero!=NULL){
+		sacar_de_mutex(mut,mut->lista_bloqueados.primero,DESP_EVENTO);
+	}
+}
+
+//Anota que el proceso actual ha obtenido el mutex libre
+static void anotar_adquisicion(mutex *mut){
+	mut->perfil.adquisiciones++;
+	if(p_proc_actual->espera_mutex){
+		mut->perfil.contendidas++;
+		p_proc_actual->espera_mutex=0;
+	}
+	mut->inicio_lock=ticks_sistema;
+}
+
+//Anota cuanto ha estado cogido el mutex que acaba de quedar libre
+static void anotar_liberacion(mutex *mut){
+	unsigned long retencion=ticks_sistema-mut->inicio_lock;
+
+	mut->perfil.retencion_total+=retencion;
+	if(retencion>mut->perfil.retencion_max){
+		mut->perfil.retencion_max=retencion;
+	}
+}
+
+/*
+ * El mutex acaba de quedar libre: se despierta al primero que lo espera
+ * y se avisa a los conjuntos de eventos que lo vigilan
+ */
+static void mutex_liberado(mutex *mut){
+	anotar_liberacion(mut);
+	despertar_mutex(mut);
+	notificar_interesados(mut->interesados);
+}
+
+/*
+ * Bloquea al proceso actual en la cola del mutex. Con espera positiva
+ * tambien se apunta en lista_temporizados y devuelve -1 si el plazo vence
+ * antes de que le despierten. Con espera 0 no llega a bloquearse.
+ */
+static int esperar_mutex(mutex *mut, long espera, unsigned long plazo){
+	int nivel, motivo;
+
+	if(espera == 0 || (espera > 0 && ticks_sistema >= plazo)) {
+		return -1;
 	}
-	  mut=p_proc_actual->descriptores_mutex_sistema[mutexid];
+	nivel = fijar_nivel_int(NIVEL_3);
+	p_proc_actual->inicio_espera = ticks_sistema;
+	p_proc_actual->espera_mutex = 1;
+	if(espera > 0) {
+		p_proc_actual->mutex_espera = mut;
+		motivo = esperar_con_plazo(&mut->lista_bloqueados, 1, plazo);
+	}
+	else
+		motivo = esperar_en_cola(&mut->lista_bloqueados, 1);
+	fijar_nivel_int(nivel);
+	return motivo == DESP_PLAZO ? -1 : 0;
+}
+
+/*
+ * Obtiene el mutex para el proceso actual, bloquendolo mientras lo tenga
+ * otro. "espera" son los ticks que se puede esperar como maximo: negativa
+ * para esperar indefinidamente y 0 para no bloquearse. Si no se obtiene a
+ * tiempo devuelve -13. Usada por lock, trylock, lock_temporizado y por
+ * esperar_condicion
+ */
+static int adquirir_mutex(mutex *mut, long espera){  
+	int bloqueado;
+	unsigned long plazo = ticks_sistema + espera;
+	
 	do {
 		bloqueado = 0;
 		if(mut->num_procesos > 0) {
@@ -678,24 +2127,9 @@ int lock(){
 					}
 					// Si no, bloqueamos al proceso
 					else {
-						p_proc_actual->estado = BLOQUEADO;
-						// Ya no se debe hacer C. de contexto involuntario
-						
-						nivel = fijar_nivel_int(NIVEL_3);
-
-						eliminar_primero(&lista_listos);
-						//Lo insertamos en la lista de bloqueados por un lock
-						insertar_ultimo(&mut->lista_bloqueados, p_proc_actual);
-						//Hacemos un C de Contexto
-						p_proc_anterior = p_proc_actual;
-						p_proc_actual = planificador();
-
-						//printk("*** C de CONTEXTO POR UN LOCK: de %d a %d\n",
-						//p_proc_anterior->id, p_proc_actual->id);
-						
-						//Restauramos el contexto del nuevo actual
-						cambio_contexto(&(p_proc_anterior->contexto_regs), &(p_proc_actual->contexto_regs));
-						fijar_nivel_int(nivel);
+						if(esperar_mutex(mut, espera, plazo) < 0) {
+							return -13;
+						}
 						//Ahora indicamos que hay que volver a comprobar para que no se 
 						//cuele ningun proceso
 						bloqueado = 1;
@@ -715,24 +2149,9 @@ int lock(){
 					}
 					//Si no es el dueo bloqueamos al proceso
 					else {
-						p_proc_actual->estado = BLOQUEADO;
-						// Ya no es necesario hacer cambio de contexto involuntario
-						
-						nivel = fijar_nivel_int(NIVEL_3);
-						
-						eliminar_primero(&lista_listos);
-						insertar_ultimo(&mut->lista_bloqueados, p_proc_actual);
-						//Hacemos un C de Contexto
-						p_proc_anterior = p_proc_actual;
-						p_proc_actual = planificador();
-
-						//printk("*** C de CONTEXTO POR UN LOCK: de %d a %d\n",
-							//p_proc_anterior->id, p_proc_actual->id);
-						//Restauramos el contexto del nuevo actual
-						cambio_contexto(&(p_proc_anterior->contexto_regs),
-							&(p_proc_actual->contexto_regs));
-						fijar_nivel_int(nivel);
-
+						if(esperar_mutex(mut, espera, plazo) < 0) {
+							return -13;
+						}
 						//Indamos que hay que volver a comprobar para que no se cuele
 						//ningun proceso
 						bloqueado = 1;
@@ -744,6 +2163,7 @@ int lock(){
 				//Bloqueamos al mutex
 				mut->valor++;
 				mut->BCP_id_lock = p_proc_actual->id;
+				anotar_adquisicion(mut);
 			}
 			else {
 				//printk("ERROR: error interno en el mutex");
@@ -761,17 +2181,55 @@ int lock(){
     }
     
     
-  unlock(){
-    BCP*aux;
-    int nivel;
-    unsigned int mutexid = (unsigned int)leer_registro(1);
-    mutex* mut;
+int lock(){  
+	mutex*mut;
+	unsigned int mutexid = (unsigned int)leer_registro(1);
+	int res;
+	
+	
+	if((mut=obtener_objeto_BCP(p_proc_actual,mutexid,OBJ_MUTEX))==NULL){
+	  return -12;
+	}
+	TRAZA(TRAZA_MUTEX, TR_PIDE_LOCK, mutexid, 0);
+	res=adquirir_mutex(mut, -1);
+	TRAZA(TRAZA_MUTEX, TR_LOCK, mutexid, res);
+	return res;
+}
+
+int trylock(){
+	mutex*mut;
+	unsigned int mutexid = (unsigned int)leer_registro(1);
+
+	if((mut=obtener_objeto_BCP(p_proc_actual,mutexid,OBJ_MUTEX))==NULL){
+	  return -12;
+	}
+	return adquirir_mutex(mut, 0);
+}
+
+/*
+ * Como lock pero esperando como mucho los milisegundos indicados,
+ * redondeados hacia arriba a ticks de reloj
+ */
+int lock_temporizado(){
+	mutex*mut;
+	unsigned int mutexid = (unsigned int)leer_registro(1);
+	long ms = (long)(int)leer_registro(2);
+
+	if((mut=obtener_objeto_BCP(p_proc_actual,mutexid,OBJ_MUTEX))==NULL){
+	  return -12;
+	}
+	if(ms < 0) {
+	  return -1;
+	}
+	return adquirir_mutex(mut, (ms*TICK+999)/1000);
+}
+
+/*
+ * Libera el mutex del proceso actual despertando al primero que espere.
+ * Usada por unlock y por esperar_condicion
+ */
+static int soltar_mutex(mutex *mut){
     
-    if(p_proc_actual->descriptores_mutex_sistema[mutexid]==NULL){
-      
-      return -18;
-    }
-    mut=p_proc_actual->descriptores_mutex_sistema[mutexid];
 	//verificamos que existe el mutex
 	if(mut->num_procesos > 0) {
 		//Comprobamos si esta bloqueado
@@ -783,16 +2241,8 @@ int lock(){
 					//Disminuimos el numero de bloqueos
 					mut->valor--;
 					if(mut->valor == 0) {
-						aux = mut->lista_bloqueados.primero;
-						//Verificamos si hay algun proc en espera
-						if(aux != NULL) {
-							//Despertamos al proceso bloqueado
-							aux->estado = LISTO;
-							nivel = fijar_nivel_int(NIVEL_3);
-							eliminar_primero(&mut->lista_bloqueados);
-							insertar_ultimo(&lista_listos, aux);
-							fijar_nivel_int(nivel);
-						}
+						//Despertamos al proceso bloqueado, si lo hay
+						mutex_liberado(mut);
 					}
 				}
 				//En caso contrario, capturamos el error
@@ -810,15 +2260,8 @@ int lock(){
 						//printk("ERROR: intento de desbloqueo del mutex no recursivo ha fallado\n");
 						return -1;
 					}
-					aux = mut->lista_bloqueados.primero;
-					//Verificamos si hay algun proceso en espera
-					if(aux != NULL) {
-						aux->estado = LISTO;
-						nivel = fijar_nivel_int(NIVEL_3);
-						eliminar_primero(&mut->lista_bloqueados);
-						insertar_ultimo(&lista_listos, aux);
-						fijar_nivel_int(nivel);
-					}
+					//Despertamos al proceso en espera, si lo hay
+					mutex_liberado(mut);
 				}
 				else {
 					//printk("ERROR: mutex tiene que ser boqueado por el mismo proceso\n");
@@ -842,141 +2285,1268 @@ int lock(){
     
   }
 
+int unlock(){
+    unsigned int mutexid = (unsigned int)leer_registro(1);
+    mutex* mut;
+    int res;
+    
+    if((mut=obtener_objeto_BCP(p_proc_actual,mutexid,OBJ_MUTEX))==NULL){
+      
+      return -18;
+    }
+    res=soltar_mutex(mut);
+    TRAZA(TRAZA_MUTEX, TR_UNLOCK, mutexid, res);
+    return res;
+}
+
 int cerrar_mutex(){
  int mutexid; 
  mutexid=(int)leer_registro(1); 
- cerrar_mutex_aux(mutexid,p_proc_actual);
+ return cerrar_mutex_aux(mutexid,p_proc_actual);
 }
 
  int cerrar_mutex_aux(int mutexid,BCP* proc){   
 
   mutex* mut;
-  int nivel;
-  if(proc->descriptores_mutex_sistema[mutexid]==NULL){
+  if((mut=obtener_mutex_BCP(proc,mutexid))==NULL){
     
     return -1;
   }
   
-  mut=p_proc_actual->descriptores_mutex_sistema[mutexid];
-  proc->numero_mutex--;
-  proc->descriptores_mutex_sistema[mutexid]=NULL;
+  quitar_descriptor_BCP(proc,mutexid);
   
-  if(mut->valor>0){
+  if(mut->clase==OBJ_RWLOCK){
     
-    mut->valor=0;
-  
-  BCP* aux = mut->lista_bloqueados.primero;
-		if(aux != NULL) {
-			aux->estado = LISTO;
-			nivel = fijar_nivel_int(NIVEL_3);
-			eliminar_primero(&mut->lista_bloqueados);
-			insertar_ultimo(&lista_listos,aux);
-			fijar_nivel_int(nivel);
+    soltar_rwlock(mut,proc); //cierre implicito del rwlock que tuviera
   }
+  else if(mut->clase==OBJ_TUBERIA){
+    
+    //quien espera debe ver si se ha quedado solo con la tuberia
+    despertar_todos(&mut->lista_bloqueados,DESP_EVENTO);
+    despertar_todos(&mut->u.tub.escritores,DESP_EVENTO);
   }
-  if(mut->BCP_id_lock == p_proc_actual->id) {
-	
-		mut->valor = 0;
-		BCP *aux = mut->lista_bloqueados.primero;
-		if(aux != NULL) {
-			aux->estado = LISTO;
-			nivel = fijar_nivel_int(NIVEL_3);
-			eliminar_elem(&mut->lista_bloqueados,aux);
-			insertar_ultimo(&lista_listos,aux);
-			fijar_nivel_int(nivel);
-		}
-	}
-  if(--mut->num_procesos==0){
-   
-    lista_mutex.contador_mutex--;
+  else if(mut->clase==OBJ_COLA){
     
+    //igual con las colas: emisores y receptores ven si siguen acompaados
+    despertar_todos(&mut->lista_bloqueados,DESP_EVENTO);
+    despertar_todos(&mut->u.cola.emisores,DESP_EVENTO);
+  }
+  else if(mut->clase==OBJ_MUTEX && mut->valor>0 && mut->BCP_id_lock==proc->id){
     
-    if(lista_mutex.bloqueados_en_espera.primero!=NULL){
-      
+    //Solo se suelta si lo tiene cogido quien lo cierra
+    mut->valor=0;
+    mutex_liberado(mut);
+  }
+  if(--mut->num_procesos==0){
    
-      
-      BCP *aux;
-      BCP *proc;
-      proc=lista_mutex.bloqueados_en_espera.primero;
-      
-         
-      aux=proc->siguiente;
-      
-      proc->estado=LISTO;
-      
-      nivel=fijar_nivel_int(NIVEL_3);
-	
-      eliminar_elem(&lista_mutex.bloqueados_en_espera,proc);
-      
-      insertar_ultimo(&lista_listos,proc);
-      
-      
-     
+    liberar_mutex_sistema(mut);
     
-      fijar_nivel_int(nivel);
-      
-    }
+    //Se entrega el mutex liberado al primero que espera uno
+    entregar_mutex_libre();
    
   }
   return 0;}
 
-void cerrar_mutex_proceso(BCP* proc){  
+void cerrar_mutex_proceso(BCP* proc){ //Cierra los mutex abiertos y devuelve las paginas de descriptores
   int i;  
-  for(i=0; (i<NUM_MUT_PROC); i++){    
-    if(proc->descriptores_mutex_sistema[i]!=NULL)
-    cerrar_mutex_aux(i,proc);
+  pagina_desc *pag;
+  for(i=0; (i<MAX_PAG_DESC); i++){    
+    if((pag=proc->paginas_desc[i])==NULL)
+      continue;
+    while(pag->mapa!=0)
+      cerrar_mutex_aux(i*DESC_POR_PAGINA+__builtin_ctzl(pag->mapa),proc);
+    liberar_obj(&cache_paginas,pag);
+    proc->paginas_desc[i]=NULL;
   }  
+  proc->paginas_llenas=0;
 }
-int abrir_mutex()
-{
-  
-
-  char* nombre;
+/*
+ * Parte comun de la apertura de objetos con nombre. Falla si el objeto
+ * existe pero es de otra clase.
+ */
+static int abrir_objeto(char *nombre, int clase){
   mutex *mut;
   int descriptor;
-   
-  
-  
-  nombre=(char*)leer_registro(1);
   
 if(nombre_valido(nombre)!=0){ //Compruebo que tenga un nombre introducido valido
  return -8; 
 }
 
-if(buscar_mutex(nombre)==NULL){//compruebo que el mutex exista
+if((mut=buscar_mutex(nombre))==NULL){//compruebo que el mutex exista
   return -9;
 }
 
+if(mut->clase!=clase){ //compruebo que sea del tipo de objeto pedido
+  return -11;
+}
 
-if (p_proc_actual->numero_mutex==NUM_MUT_PROC){ //Compruebo que haya descriptores libres
+if ((descriptor=buscar_descriptor_BCP(p_proc_actual))<0){ //Compruebo que haya descriptores libres
 		
   return -10;
 
 }
 
-mut=buscar_mutex(nombre);
+fijar_descriptor_BCP(p_proc_actual,descriptor,mut);
 
 
+printk("NOMBRE DESCRIPTOR %s\n",mut->nombre_mutex);
+mut->num_procesos++;
 
-descriptor =  buscar_descriptor_BCP(p_proc_actual);
+	
 
-p_proc_actual->numero_mutex++;
+      return descriptor;
+}
 
-p_proc_actual->descriptores_mutex_sistema[descriptor]=mut;
+int abrir_mutex()
+{
+  return abrir_objeto((char*)leer_registro(1),OBJ_MUTEX);
+}
 
+/*
+ *
+ * Rutinas de los rwlock: crear_rwlock abrir_rwlock lock_lectura
+ * lock_escritura unlock_rw
+ *
+ * Un rwlock es un objeto mas de la tabla de mutex. El escritor usa los
+ * campos valor, BCP_id_lock y lista_bloqueados del mutex; los lectores,
+ * los campos de u.rw. Quien libera el rwlock se lo cede a los procesos
+ * que despierta, asi que estos no tienen que volver a comprobarlo.
+ *
+ */
 
-printk("NOMBRE DESCRIPTOR %s\n",p_proc_actual->descriptores_mutex_sistema[descriptor]->nombre_mutex);
-mut->num_procesos++;
+//Cede el rwlock a todos los lectores bloqueados, en una sola pasada
+static void despertar_lectores(mutex *rw){
+	BCP *p;
 
-	
+	for(p=rw->u.rw.lista_lectores.primero;p!=NULL;p=p->siguiente){
+		rw->u.rw.lectores++;
+		rw->u.rw.mapa_lectores|=1UL<<p->id;
+	}
+	despertar_todos(&rw->u.rw.lista_lectores,DESP_EVENTO);
+}
 
-      return descriptor;
+//Cede el rwlock al primer escritor bloqueado
+static void despertar_escritor(mutex *rw){
+	rw->u.rw.escritores_esperando--;
+	rw->valor=1;
+	rw->BCP_id_lock=rw->lista_bloqueados.primero->id;
+	despertar_uno(&rw->lista_bloqueados,DESP_EVENTO);
+}
+
+/*
+ * Libera el rwlock que tenga el proceso (como escritor o como lector) y,
+ * si queda libre, se lo cede a un escritor o a todos los lectores que
+ * esperan. Con PREF_ESCRITURA los escritores van siempre primero.
+ */
+static int soltar_rwlock(mutex *rw,BCP *proc){
+	if(rw->valor>0 && rw->BCP_id_lock==proc->id){
+		rw->valor=0;
+		rw->BCP_id_lock=-1;
+	}
+	else if(rw->u.rw.mapa_lectores&(1UL<<proc->id)){
+		rw->u.rw.mapa_lectores&=~(1UL<<proc->id);
+		rw->u.rw.lectores--;
+	}
+	else{
+		return -1; //no lo tiene
+	}
+	if(rw->valor>0 || rw->u.rw.lectores>0){
+		return 0;
+	}
+	if(rw->u.rw.escritores_esperando>0 &&
+	   (rw->u.rw.preferencia==PREF_ESCRITURA || rw->u.rw.lista_lectores.primero==NULL)){
+		despertar_escritor(rw);
+	}
+	else if(rw->u.rw.lista_lectores.primero!=NULL){
+		despertar_lectores(rw);
+	}
+	return 0;
+}
+
+int crear_rwlock(){
+	char *nombre;
+	int preferencia;
+	int descriptor;
+	mutex *rw;
+
+	nombre=(char*)leer_registro(1);
+	preferencia=(int)leer_registro(2);
+
+	if((descriptor=crear_objeto(nombre,OBJ_RWLOCK,&rw))<0){
+	  return descriptor;
+	}
+	rw->u.rw.lista_lectores.primero=NULL;
+	rw->u.rw.lista_lectores.ultimo=NULL;
+	rw->u.rw.lectores=0;
+	rw->u.rw.mapa_lectores=0;
+	rw->u.rw.escritores_esperando=0;
+	rw->u.rw.preferencia=preferencia;
+	return descriptor;
 }
 
+int abrir_rwlock(){
+	return abrir_objeto((char*)leer_registro(1),OBJ_RWLOCK);
+}
+
+int lock_lectura(){
+	mutex *rw;
+	unsigned int rwid=(unsigned int)leer_registro(1);
+
+	if((rw=obtener_objeto_BCP(p_proc_actual,rwid,OBJ_RWLOCK))==NULL){
+		return -12;
+	}
+	//Ya lo tiene como lector o como escritor: se produciria interbloqueo
+	if((rw->u.rw.mapa_lectores&(1UL<<p_proc_actual->id)) ||
+	   (rw->valor>0 && rw->BCP_id_lock==p_proc_actual->id)){
+		return -1;
+	}
+	//Con PREF_ESCRITURA un lector nuevo no adelanta a los escritores que esperan
+	if(rw->valor==0 &&
+	   (rw->u.rw.preferencia==PREF_LECTURA || rw->u.rw.escritores_esperando==0)){
+		rw->u.rw.lectores++;
+		rw->u.rw.mapa_lectores|=1UL<<p_proc_actual->id;
+		return 0;
+	}
+	//Al despertar ya es lector: se lo ha cedido despertar_lectores
+	esperar_en_cola(&rw->u.rw.lista_lectores,0);
+	return 0;
+}
 
+int lock_escritura(){
+	mutex *rw;
+	unsigned int rwid=(unsigned int)leer_registro(1);
 
+	if((rw=obtener_objeto_BCP(p_proc_actual,rwid,OBJ_RWLOCK))==NULL){
+		return -12;
+	}
+	if((rw->u.rw.mapa_lectores&(1UL<<p_proc_actual->id)) ||
+	   (rw->valor>0 && rw->BCP_id_lock==p_proc_actual->id)){
+		return -1;
+	}
+	if(rw->valor==0 && rw->u.rw.lectores==0){
+		rw->valor=1;
+		rw->BCP_id_lock=p_proc_actual->id;
+		return 0;
+	}
+	//Al despertar ya es el escritor: se lo ha cedido despertar_escritor
+	rw->u.rw.escritores_esperando++;
+	esperar_en_cola(&rw->lista_bloqueados,1);
+	return 0;
+}
 
+int unlock_rw(){
+	mutex *rw;
+	unsigned int rwid=(unsigned int)leer_registro(1);
 
+	if((rw=obtener_objeto_BCP(p_proc_actual,rwid,OBJ_RWLOCK))==NULL){
+		return -18;
+	}
+	return soltar_rwlock(rw,p_proc_actual);
+}
 
+/*
+ *
+ * Rutinas de las variables condicion: crear_condicion abrir_condicion
+ * esperar_condicion senalar difundir
+ *
+ * Una condicion es otro objeto de la tabla de mutex. Los procesos que
+ * esperan en ella usan su lista_bloqueados y todos lo hacen con el mismo
+ * mutex (u.cond.mutex_asociado). Al despertarlos, si el mutex esta ocupado
+ * se pasan directamente a la lista de bloqueados del mutex en lugar de a
+ * la de listos, ya que solo podrian volver a bloquearse en el.
+ *
+ */
 
+//Pasa el primer proceso que espera en la condicion al mutex. Si esta libre
+//se le entrega ya cogido, para que si muere antes de ejecutar lo suelte su
+//cierre y no se queden sin despertar los que esperan detras
+static void despertar_condicion(mutex *cond){
+	BCP *p=cond->lista_bloqueados.primero;
+	mutex *mut=cond->u.cond.mutex_asociado;
+	int nivel;
 
+	nivel=fijar_nivel_int(NIVEL_3);
+	if(mut->valor==0){
+		mut->valor=1;
+		mut->BCP_id_lock=p->id;
+		mut->perfil.adquisiciones++;
+		mut->inicio_lock=ticks_sistema;
+		despertar_proceso(&cond->lista_bloqueados,p,DESP_EVENTO);
+		fijar_nivel_int(nivel);
+		return;
+	}
+	eliminar_primero(&cond->lista_bloqueados);
+	encolar_en_mutex(mut,p);
+	fijar_nivel_int(nivel);
+}
+
+int crear_condicion(){
+	int descriptor;
+	mutex *cond;
+
+	if((descriptor=crear_objeto((char*)leer_registro(1),OBJ_CONDICION,&cond))<0){
+	  return descriptor;
+	}
+	cond->u.cond.mutex_asociado=NULL;
+	return descriptor;
+}
+
+int abrir_condicion(){
+	return abrir_objeto((char*)leer_registro(1),OBJ_CONDICION);
+}
+
+int esperar_condicion(){
+	mutex *cond, *mut;
+	int nivel, veces, res;
+	unsigned int condid=(unsigned int)leer_registro(1);
+	unsigned int mutexid=(unsigned int)leer_registro(2);
+
+	if((cond=obtener_objeto_BCP(p_proc_actual,condid,OBJ_CONDICION))==NULL){
+		return -12;
+	}
+	if((mut=obtener_objeto_BCP(p_proc_actual,mutexid,OBJ_MUTEX))==NULL){
+		return -12;
+	}
+	//Hay que tener el mutex, y ser el mismo que el de los que ya esperan
+	if(mut->valor==0 || mut->BCP_id_lock!=p_proc_actual->id){
+		return -1;
+	}
+	if(cond->lista_bloqueados.primero!=NULL && cond->u.cond.mutex_asociado!=mut){
+		return -1;
+	}
+	cond->u.cond.mutex_asociado=mut;
+
+	//Soltar el mutex y bloquearse en la condicion se hace sin interrupciones
+	nivel=fijar_nivel_int(NIVEL_3);
+	veces=mut->valor; //un mutex recursivo se suelta del todo
+	mut->valor=1;
+	soltar_mutex(mut);
+	esperar_en_cola(&cond->lista_bloqueados,1);
+	fijar_nivel_int(nivel);
+
+	//Puede que ya se lo hayan entregado al despertarle. Si no se recupera
+	//(se ha cerrado mientras esperaba) no es suyo
+	if(mut->valor>0 && mut->BCP_id_lock==p_proc_actual->id)
+		res=0;
+	else
+		res=adquirir_mutex(mut,-1);
+	if(res>=0)
+		mut->valor=veces;
+	return res;
+}
+
+int senalar(){
+	mutex *cond;
+	unsigned int condid=(unsigned int)leer_registro(1);
+
+	if((cond=obtener_objeto_BCP(p_proc_actual,condid,OBJ_CONDICION))==NULL){
+		return -12;
+	}
+	if(cond->lista_bloqueados.primero!=NULL){
+		despertar_condicion(cond);
+	}
+	return 0;
+}
+
+int difundir(){
+	mutex *cond;
+	BCP *p;
+	int nivel;
+	unsigned int condid=(unsigned int)leer_registro(1);
+
+	if((cond=obtener_objeto_BCP(p_proc_actual,condid,OBJ_CONDICION))==NULL){
+		return -12;
+	}
+	if(cond->lista_bloqueados.primero==NULL){
+		return 0;
+	}
+	//El primero pasa al mutex (o lo recibe, si esta libre). Asi el mutex
+	//queda cogido y el resto se encola de una vez en el: lo iran recibiendo
+	//con cada unlock
+	nivel=fijar_nivel_int(NIVEL_3);
+	despertar_condicion(cond);
+	for(p=cond->lista_bloqueados.primero;p!=NULL;p=p->siguiente){
+		p->inicio_espera=ticks_sistema;
+		p->espera_mutex=1;
+	}
+	insertar_lista_ultimo(&cond->u.cond.mutex_asociado->lista_bloqueados,&cond->lista_bloqueados);
+	fijar_nivel_int(nivel);
+	return 0;
+}
+
+/*
+ *
+ * Rutinas de los semaforos: crear_semaforo abrir_semaforo sem_esperar
+ * sem_senalar
+ *
+ * Un semaforo es otro objeto de la tabla de mutex. Las esperas piden
+ * varias unidades de una vez y se atienden en orden de llegada: quien
+ * suma unidades se las reparte a los que esperan, asi que estos no
+ * vuelven a comprobar nada al despertar.
+ *
+ */
+
+//Despierta, en una sola seccion sin interrupciones, a todos los que esperan
+//y ya tienen sus unidades, por orden de llegada
+static void repartir_semaforo(mutex *sem){
+	BCP *p;
+	int nivel;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	while((p=sem->lista_bloqueados.primero)!=NULL && p->unidades_sem<=sem->u.sem.valor){
+		sem->u.sem.valor-=p->unidades_sem;
+		despertar_proceso(&sem->lista_bloqueados,p,DESP_EVENTO);
+	}
+	fijar_nivel_int(nivel);
+}
+
+int crear_semaforo(){
+	char *nombre;
+	int valor;
+	int descriptor;
+	mutex *sem;
+
+	nombre=(char*)leer_registro(1);
+	valor=(int)leer_registro(2);
+
+	if(valor<0){
+		return -1;
+	}
+	if((descriptor=crear_objeto(nombre,OBJ_SEMAFORO,&sem))<0){
+	  return descriptor;
+	}
+	sem->u.sem.valor=valor;
+	return descriptor;
+}
+
+int abrir_semaforo(){
+	return abrir_objeto((char*)leer_registro(1),OBJ_SEMAFORO);
+}
+
+int sem_esperar(){
+	mutex *sem;
+	unsigned int semid=(unsigned int)leer_registro(1);
+	int n=(int)leer_registro(2);
+
+	if((sem=obtener_objeto_BCP(p_proc_actual,semid,OBJ_SEMAFORO))==NULL){
+		return -12;
+	}
+	if(n<=0){
+		return -1;
+	}
+	//No se adelanta a los que ya esperan aunque haya unidades
+	if(sem->lista_bloqueados.primero==NULL && sem->u.sem.valor>=n){
+		sem->u.sem.valor-=n;
+		return 0;
+	}
+	p_proc_actual->unidades_sem=n;
+	esperar_en_cola(&sem->lista_bloqueados,1);
+	return 0;
+}
+
+int sem_senalar(){
+	mutex *sem;
+	unsigned int semid=(unsigned int)leer_registro(1);
+	int n=(int)leer_registro(2);
+
+	if((sem=obtener_objeto_BCP(p_proc_actual,semid,OBJ_SEMAFORO))==NULL){
+		return -12;
+	}
+	if(n<=0){
+		return -1;
+	}
+	sem->u.sem.valor+=n;
+	repartir_semaforo(sem);
+	return 0;
+}
+
+/*
+ *
+ * Rutinas de las barreras: crear_barrera abrir_barrera esperar_barrera
+ *
+ * Una barrera es otro objeto de la tabla de mutex. Los procesos que
+ * llegan se bloquean en su lista_bloqueados y el ultimo en llegar los
+ * pasa todos de una vez a la lista de listos. La barrera queda lista para
+ * la siguiente generacion sin tener que volver a crearla.
+ *
+ */
+
+int crear_barrera(){
+	char *nombre;
+	int participantes;
+	int descriptor;
+	mutex *bar;
+
+	nombre=(char*)leer_registro(1);
+	participantes=(int)leer_registro(2);
+
+	if(participantes<=0){
+		return -1;
+	}
+	if((descriptor=crear_objeto(nombre,OBJ_BARRERA,&bar))<0){
+	  return descriptor;
+	}
+	bar->u.barrera.participantes=participantes;
+	bar->u.barrera.llegados=0;
+	bar->u.barrera.generacion=0;
+	return descriptor;
+}
+
+int abrir_barrera(){
+	return abrir_objeto((char*)leer_registro(1),OBJ_BARRERA);
+}
+
+/*
+ * Devuelve 1 al ultimo proceso en llegar y 0 al resto, para que uno solo
+ * de ellos pueda hacer el trabajo de cambio de fase
+ */
+int esperar_barrera(){
+	mutex *bar;
+	unsigned int barid=(unsigned int)leer_registro(1);
+
+	if((bar=obtener_objeto_BCP(p_proc_actual,barid,OBJ_BARRERA))==NULL){
+		return -12;
+	}
+	if(++bar->u.barrera.llegados<bar->u.barrera.participantes){
+		esperar_en_cola(&bar->lista_bloqueados,0);
+		return 0;
+	}
+	//Ultimo en llegar: despierta a la generacion entera y reinicia la barrera
+	despertar_todos(&bar->lista_bloqueados,DESP_EVENTO);
+	bar->u.barrera.llegados=0;
+	bar->u.barrera.generacion++;
+	return 1;
+}
+
+/*
+ *
+ * Rutina de perfil de los mutex: estadisticas_mutex
+ *
+ * Copia en el vector del usuario las entradas de los n mutex con mas
+ * ticks de espera acumulados, de mayor a menor, y devuelve cuantas ha
+ * copiado. Solo aparecen los mutex que siguen abiertos.
+ *
+ */
+
+//Indica si el mutex a esta mas contendido que el b
+static int mas_contendido(perfil_mutex *a, perfil_mutex *b){
+	if(a->espera_total!=b->espera_total){
+		return a->espera_total>b->espera_total;
+	}
+	return a->contendidas>b->contendidas;
+}
+
+int estadisticas_mutex(){
+	mutex *mut;
+	int i, j, nivel, copiadas=0;
+	est_mutex *tabla=(est_mutex*)leer_registro(1);
+	int n=(int)leer_registro(2);
+
+	if(tabla==NULL || n<=0){
+		return -1;
+	}
+	nivel=fijar_nivel_int(NIVEL_3);
+	for(i=0;i<TAM_HASH_MUT;i++){
+		for(mut=lista_mutex.hash[i];mut!=NULL;mut=mut->siguiente){
+			if(mut->clase!=OBJ_MUTEX){
+				continue;
+			}
+			//Insercion ordenada; si el vector esta lleno se pierde el ultimo
+			for(j=copiadas;j>0 && mas_contendido(&mut->perfil,&tabla[j-1].perfil);j--){
+				if(j<n){
+					tabla[j]=tabla[j-1];
+				}
+			}
+			if(j<n){
+				strcpy(tabla[j].nombre,mut->nombre_mutex);
+				tabla[j].perfil=mut->perfil;
+				if(copiadas<n){
+					copiadas++;
+				}
+			}
+		}
+	}
+	fijar_nivel_int(nivel);
+	return copiadas;
+}
+
+/*
+ *
+ * Rutinas de los conjuntos de eventos:
+ *	crear_eventos anadir_evento esperar_eventos
+ *
+ * Un conjunto de eventos es un objeto anonimo de la tabla de mutex, y se
+ * cierra con cerrar_mutex. Se le anaden las fuentes que se quieren
+ * vigilar y esperar_eventos bloquea una sola vez hasta que alguna tenga
+ * un evento, devolviendo la lista de las que lo tienen.
+ *
+ */
+
+/*
+ * Quita el interes de la lista de interesados de su fuente
+ */
+static void desenganchar_interes(interes *i){
+	interes **p;
+
+	if(i->tipo==EV_TERMINAL)
+		p=&terminal.interesados;
+	else if(i->tipo==EV_TEMPORIZADOR)
+		p=&temporizadores_ev;
+	else if(i->fuente!=NULL)
+		p=&i->fuente->interesados;
+	else
+		return;
+	while(*p!=i)
+		p=&(*p)->sig_fuente;
+	*p=i->sig_fuente;
+}
+
+//Devuelve a la lista de libres los intereses de un conjunto que se destruye
+static void liberar_conjunto(mutex *conj){
+	interes *i;
+	int nivel;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	while((i=conj->u.ev.intereses)!=NULL){
+		conj->u.ev.intereses=i->sig_conjunto;
+		desenganchar_interes(i);
+		liberar_obj(&cache_intereses,i);
+	}
+	fijar_nivel_int(nivel);
+}
+
+//Los intereses en un objeto que se destruye se quedan sin fuente
+static void olvidar_fuente(mutex *mut){
+	interes *i;
+	int nivel;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	for(i=mut->interesados; i!=NULL; i=i->sig_fuente)
+		i->fuente=NULL;
+	mut->interesados=NULL;
+	fijar_nivel_int(nivel);
+}
+
+int crear_eventos(){
+	int descriptor;
+	mutex *conj;
+
+	if((descriptor=crear_objeto(NULL,OBJ_EVENTOS,&conj))<0){
+		return descriptor;
+	}
+	conj->u.ev.intereses=NULL;
+	conj->u.ev.primero_listo=NULL;
+	conj->u.ev.ultimo_listo=NULL;
+	conj->u.ev.num_intereses=0;
+	conj->u.ev.siguiente_id=0;
+	return descriptor;
+}
+
+/*
+ * Anade al conjunto una fuente a vigilar y devuelve el id con el que
+ * esperar_eventos la identifica. dato es el descriptor del objeto para
+ * EV_MUTEX, EV_TUBERIA y EV_COLA, y el periodo en milisegundos para
+ * EV_TEMPORIZADOR. Si la fuente ya tiene el evento (hay datos, el mutex
+ * esta libre) queda lista desde el principio
+ */
+int anadir_evento(){
+	unsigned int conjid=(unsigned int)leer_registro(1);
+	int tipo=(int)leer_registro(2);
+	int dato=(int)leer_registro(3);
+	mutex *conj, *fuente=NULL;
+	interes *i;
+	int nivel;
+
+	if((conj=obtener_objeto_BCP(p_proc_actual,conjid,OBJ_EVENTOS))==NULL){
+		return -12;
+	}
+	if(conj->u.ev.num_intereses>=MAX_INTERESES){
+		return -7;
+	}
+	if(tipo==EV_MUTEX){
+		if((fuente=obtener_objeto_BCP(p_proc_actual,dato,OBJ_MUTEX))==NULL){
+			return -12;
+		}
+	}
+	else if(tipo==EV_TUBERIA){
+		if((fuente=obtener_objeto_BCP(p_proc_actual,dato,OBJ_TUBERIA))==NULL){
+			return -12;
+		}
+	}
+	else if(tipo==EV_COLA){
+		if((fuente=obtener_objeto_BCP(p_proc_actual,dato,OBJ_COLA))==NULL){
+			return -12;
+		}
+	}
+	else if(tipo==EV_TEMPORIZADOR){
+		if(dato<=0){
+			return -1;
+		}
+	}
+	else if(tipo!=EV_TERMINAL){
+		return -1;
+	}
+	nivel=fijar_nivel_int(NIVEL_3);
+	if((i=reservar_obj(&cache_intereses))==NULL){
+		fijar_nivel_int(nivel);
+		return -1;
+	}
+	i->conjunto=conj;
+	i->id=conj->u.ev.siguiente_id++;
+	i->tipo=tipo;
+	i->fuente=fuente;
+	i->listo=0;
+	i->sig_conjunto=conj->u.ev.intereses;
+	conj->u.ev.intereses=i;
+	conj->u.ev.num_intereses++;
+	if(tipo==EV_TERMINAL){
+		i->sig_fuente=terminal.interesados;
+		terminal.interesados=i;
+		if(terminal.num>0)
+			marcar_listo(i);
+	}
+	else if(tipo!=EV_TEMPORIZADOR){
+		i->sig_fuente=fuente->interesados;
+		fuente->interesados=i;
+		if((tipo==EV_MUTEX && fuente->valor==0) ||
+		   (tipo==EV_TUBERIA && fuente->u.tub.num>0) ||
+		   (tipo==EV_COLA && fuente->u.cola.num>0))
+			marcar_listo(i);
+	}
+	else{
+		i->periodo=((long)dato*TICK+999)/1000;
+		i->proximo=ticks_sistema+i->periodo;
+		insertar_temporizador_ev(i);
+	}
+	fijar_nivel_int(nivel);
+	return i->id;
+}
+
+/*
+ * Copia en listos hasta max eventos pendientes del conjunto y devuelve
+ * cuantos ha copiado. Si no hay ninguno espera como mucho los
+ * milisegundos indicados (negativo: sin limite, 0: no espera) y devuelve
+ * 0 si vence el plazo
+ */
+int esperar_eventos(){
+	unsigned int conjid=(unsigned int)leer_registro(1);
+	evento *listos=(evento *)leer_registro(2);
+	int max=(int)leer_registro(3);
+	long ms=(long)(int)leer_registro(4);
+	unsigned long plazo=ticks_sistema+(ms*TICK+999)/1000;
+	mutex *conj;
+	interes *i;
+	int nivel, n=0;
+
+	if((conj=obtener_objeto_BCP(p_proc_actual,conjid,OBJ_EVENTOS))==NULL){
+		return -12;
+	}
+	if(listos==NULL || max<=0){
+		return -1;
+	}
+	nivel=fijar_nivel_int(NIVEL_3);
+	while(conj->u.ev.primero_listo==NULL){
+		if(ms==0 || (ms>0 && ticks_sistema>=plazo))
+			break;
+		if(ms<0)
+			esperar_en_cola(&conj->lista_bloqueados, 1);
+		else if(esperar_con_plazo(&conj->lista_bloqueados, 1, plazo)==DESP_PLAZO)
+			break;
+	}
+	while(n<max && (i=conj->u.ev.primero_listo)!=NULL){
+		conj->u.ev.primero_listo=i->sig_listo;
+		i->listo=0;
+		listos[n].id=i->id;
+		listos[n].tipo=i->tipo;
+		n++;
+	}
+	//Lo que quede es para el siguiente que espere
+	if(conj->u.ev.primero_listo!=NULL)
+		despertar_uno(&conj->lista_bloqueados, DESP_EVENTO);
+	fijar_nivel_int(nivel);
+	return n;
+}
+
+/*
+ *
+ * Rutinas de las tuberias:
+ *	crear_tuberia abrir_tuberia escribir_tuberia leer_tuberia
+ *
+ * Una tuberia es un buffer circular de TAM_TUBERIA bytes en la tabla de
+ * mutex, con nombre o anonima, y se cierra con cerrar_mutex. Las anonimas
+ * las heredan con el mismo descriptor los procesos que se crean despues.
+ * Todos los procesos comparten el espacio de direcciones, asi que si hay
+ * un lector esperando con la tuberia vacia el escritor copia directamente
+ * en su buffer y los datos no pasan por el de la tuberia. Si el proceso
+ * es el unico que tiene abierta la tuberia no se bloquea: leer devuelve 0
+ * y escribir lo que haya podido dejar.
+ *
+ */
+
+//Da al hijo los descriptores de las tuberias anonimas que tiene el padre.
+//Si no hay paginas de descriptores para todas le cierra las que ya tenga,
+//para que num_procesos siga contando solo a quien las tiene, y falla
+static int heredar_tuberias(BCP *padre, BCP *hijo){
+	mutex *tub;
+	int descriptor;
+
+	for(descriptor=0;descriptor<MAX_MUT_PROC;descriptor++){
+		tub=obtener_objeto_BCP(padre,descriptor,OBJ_TUBERIA);
+		if(tub==NULL || tub->nombre_mutex[0]!='\0'){
+			continue;
+		}
+		if(hijo->paginas_desc[descriptor/DESC_POR_PAGINA]==NULL &&
+		   (hijo->paginas_desc[descriptor/DESC_POR_PAGINA]=reservar_pagina_desc())==NULL){
+			cerrar_mutex_proceso(hijo);
+			return -1;
+		}
+		fijar_descriptor_BCP(hijo,descriptor,tub);
+		tub->num_procesos++;
+	}
+	return 0;
+}
+
+/*
+ * Crea una tuberia con el nombre dado, o anonima si es NULL
+ */
+int crear_tuberia(){
+	char *nombre=(char*)leer_registro(1);
+	int descriptor;
+	mutex *tub;
+	char *datos;
+
+	if(cargar_memoria(p_proc_actual,MEM_IPC,TAM_TUBERIA)<0){
+		return -7;
+	}
+	if((datos=reservar_obj(&cache_tuberias))==NULL){
+		cargar_memoria(p_proc_actual,MEM_IPC,-TAM_TUBERIA);
+		return -1;
+	}
+	if((descriptor=crear_objeto(nombre,OBJ_TUBERIA,&tub))<0){
+		liberar_obj(&cache_tuberias,datos);
+		cargar_memoria(p_proc_actual,MEM_IPC,-TAM_TUBERIA);
+		return descriptor;
+	}
+	tub->bloque=datos;
+	tub->cache_bloque=&cache_tuberias;
+	cargar_objeto(tub,TAM_TUBERIA);
+	tub->u.tub.datos=datos;
+	tub->u.tub.primero=0;
+	tub->u.tub.num=0;
+	tub->u.tub.escritores.primero=NULL;
+	tub->u.tub.escritores.ultimo=NULL;
+	return descriptor;
+}
+
+int abrir_tuberia(){
+	return abrir_objeto((char*)leer_registro(1),OBJ_TUBERIA);
+}
+
+/*
+ * Mete en el buffer de la tuberia lo que quepa de los n bytes y devuelve
+ * cuantos ha metido. Son dos copias si se da la vuelta al buffer
+ */
+static int meter_tuberia(mutex *tub, char *buf, int n){
+	int fin=(tub->u.tub.primero+tub->u.tub.num)%TAM_TUBERIA;
+	int k, trozo;
+
+	if(n>TAM_TUBERIA-tub->u.tub.num){
+		n=TAM_TUBERIA-tub->u.tub.num;
+	}
+	for(k=0;k<n;k+=trozo){
+		trozo=n-k;
+		if(trozo>TAM_TUBERIA-fin){
+			trozo=TAM_TUBERIA-fin;
+		}
+		memcpy(tub->u.tub.datos+fin,buf+k,trozo);
+		fin=(fin+trozo)%TAM_TUBERIA;
+	}
+	tub->u.tub.num+=n;
+	return n;
+}
+
+//Saca del buffer de la tuberia hasta n bytes y devuelve cuantos ha sacado
+static int sacar_tuberia(mutex *tub, char *buf, int n){
+	int k, trozo;
+
+	if(n>tub->u.tub.num){
+		n=tub->u.tub.num;
+	}
+	for(k=0;k<n;k+=trozo){
+		trozo=n-k;
+		if(trozo>TAM_TUBERIA-tub->u.tub.primero){
+			trozo=TAM_TUBERIA-tub->u.tub.primero;
+		}
+		memcpy(buf+k,tub->u.tub.datos+tub->u.tub.primero,trozo);
+		tub->u.tub.primero=(tub->u.tub.primero+trozo)%TAM_TUBERIA;
+	}
+	tub->u.tub.num-=n;
+	return n;
+}
+
+/*
+ * Escribe los n bytes, bloqueandose mientras la tuberia este llena.
+ * Devuelve los bytes escritos, que solo son menos de n si el proceso se
+ * queda solo con la tuberia
+ */
+int escribir_tuberia(){
+	unsigned int tubid=(unsigned int)leer_registro(1);
+	char *buf=(char*)leer_registro(2);
+	int n=(int)leer_registro(3);
+	mutex *tub;
+	BCP *lector;
+	int nivel, k, hecho=0;
+
+	if((tub=obtener_objeto_BCP(p_proc_actual,tubid,OBJ_TUBERIA))==NULL){
+		return -12;
+	}
+	if(buf==NULL || n<0){
+		return -1;
+	}
+	nivel=fijar_nivel_int(NIVEL_3);
+	while(hecho<n){
+		//Entrega directa al primer lector que espera con la tuberia vacia
+		if(tub->u.tub.num==0 && (lector=tub->lista_bloqueados.primero)!=NULL){
+			k=n-hecho<lector->io_tam ? n-hecho : lector->io_tam;
+			memcpy(lector->io_buf,buf+hecho,k);
+			lector->io_hecho=k;
+			hecho+=k;
+			despertar_proceso(&tub->lista_bloqueados,lector,DESP_EVENTO);
+		}
+		else if(tub->u.tub.num<TAM_TUBERIA){
+			hecho+=meter_tuberia(tub,buf+hecho,n-hecho);
+			despertar_uno(&tub->lista_bloqueados,DESP_EVENTO);
+			notificar_interesados(tub->interesados);
+		}
+		else if(tub->num_procesos==1){
+			break;
+		}
+		else{
+			esperar_en_cola(&tub->u.tub.escritores,1);
+		}
+	}
+	//Si ha quedado sitio, para el siguiente escritor
+	if(tub->u.tub.num<TAM_TUBERIA){
+		despertar_uno(&tub->u.tub.escritores,DESP_EVENTO);
+	}
+	fijar_nivel_int(nivel);
+	return hecho;
+}
+
+/*
+ * Lee hasta n bytes, bloqueandose mientras la tuberia este vacia, y
+ * devuelve los leidos. Devuelve 0 si esta vacia y nadie mas la tiene
+ * abierta
+ */
+int leer_tuberia(){
+	unsigned int tubid=(unsigned int)leer_registro(1);
+	char *buf=(char*)leer_registro(2);
+	int n=(int)leer_registro(3);
+	mutex *tub;
+	int nivel, leidos=0;
+
+	if((tub=obtener_objeto_BCP(p_proc_actual,tubid,OBJ_TUBERIA))==NULL){
+		return -12;
+	}
+	if(buf==NULL || n<=0){
+		return -1;
+	}
+	nivel=fijar_nivel_int(NIVEL_3);
+	while(tub->u.tub.num==0 && tub->num_procesos>1){
+		p_proc_actual->io_buf=buf;
+		p_proc_actual->io_tam=n;
+		p_proc_actual->io_hecho=0;
+		esperar_en_cola(&tub->lista_bloqueados,1);
+		if((leidos=p_proc_actual->io_hecho)>0){
+			break;
+		}
+	}
+	if(leidos==0){
+		leidos=sacar_tuberia(tub,buf,n);
+	}
+	if(leidos>0){
+		despertar_uno(&tub->u.tub.escritores,DESP_EVENTO);
+	}
+	//Si quedan datos, para el siguiente lector
+	if(tub->u.tub.num>0){
+		despertar_uno(&tub->lista_bloqueados,DESP_EVENTO);
+	}
+	fijar_nivel_int(nivel);
+	return leidos;
+}
+
+/*
+ *
+ * Rutinas de las colas de mensajes:
+ *	crear_cola abrir_cola enviar_lote recibir_lote
+ *
+ * Los mensajes se guardan en la arena de la cola, en una lista por
+ * prioridad. El mapa de bits de prioridades no vacias permite sacar el de
+ * mayor prioridad sin recorrerlas. Cada llamada mueve un vector de
+ * mensajes; enviar y recibir de la biblioteca son lotes de uno.
+ *
+ */
+
+int crear_cola(){
+	char *nombre=(char*)leer_registro(1);
+	int max_msgs=(int)leer_registro(2);
+	int max_tam=(int)leer_registro(3);
+	int descriptor, tam_hueco, tam, cargado, i;
+	arena_cola *arena;
+	msg_cola *hueco;
+	mutex *cola;
+
+	if(nombre==NULL){
+		return -2;
+	}
+	if(max_msgs<=0 || max_msgs>MAX_MSGS_COLA || max_tam<=0 || max_tam>MAX_TAM_MSG){
+		return -1;
+	}
+	tam_hueco=(sizeof(msg_cola)+max_tam+7)&~7;
+	tam=sizeof(arena_cola)+max_msgs*tam_hueco;
+	if(cargar_memoria(p_proc_actual,MEM_IPC,tam)<0){
+		return -7;
+	}
+	cargado=tam;
+	if((arena=reservar_bloque(&tam))==NULL){
+		cargar_memoria(p_proc_actual,MEM_IPC,-cargado);
+		return -1;
+	}
+	if((descriptor=crear_objeto(nombre,OBJ_COLA,&cola))<0){
+		devolver_bloque(arena,tam);
+		cargar_memoria(p_proc_actual,MEM_IPC,-cargado);
+		return descriptor;
+	}
+	cola->bloque=arena;
+	cola->tam_bloque=tam;
+	cargar_objeto(cola,cargado);
+	arena->libres=NULL;
+	for(i=0;i<max_msgs;i++){
+		hueco=(msg_cola*)((char*)(arena+1)+i*tam_hueco);
+		hueco->siguiente=arena->libres;
+		arena->libres=hueco;
+	}
+	for(i=0;i<NUM_PRIOS_MSG;i++){
+		arena->primero[i]=NULL;
+		arena->ultimo[i]=NULL;
+	}
+	cola->u.cola.arena=arena;
+	cola->u.cola.mapa=0;
+	cola->u.cola.num=0;
+	cola->u.cola.max_msgs=max_msgs;
+	cola->u.cola.max_tam=max_tam;
+	cola->u.cola.emisores.primero=NULL;
+	cola->u.cola.emisores.ultimo=NULL;
+	return descriptor;
+}
+
+int abrir_cola(){
+	return abrir_objeto((char*)leer_registro(1),OBJ_COLA);
+}
+
+//Copia el mensaje en un hueco libre, al final de los de su prioridad
+static void meter_mensaje(mutex *cola, mensaje *m){
+	arena_cola *arena=cola->u.cola.arena;
+	msg_cola *hueco=arena->libres;
+
+	arena->libres=hueco->siguiente;
+	memcpy(hueco->datos,m->buf,m->tam);
+	hueco->tam=m->tam;
+	hueco->prio=m->prio;
+	hueco->siguiente=NULL;
+	if(arena->primero[m->prio]==NULL)
+		arena->primero[m->prio]=hueco;
+	else
+		arena->ultimo[m->prio]->siguiente=hueco;
+	arena->ultimo[m->prio]=hueco;
+	cola->u.cola.mapa|=1U<<m->prio;
+	cola->u.cola.num++;
+}
+
+//Saca el mensaje mas antiguo de la mayor prioridad con mensajes
+static void sacar_mensaje(mutex *cola, mensaje *m){
+	arena_cola *arena=cola->u.cola.arena;
+	int prio=31-__builtin_clz(cola->u.cola.mapa);
+	msg_cola *hueco=arena->primero[prio];
+
+	if((arena->primero[prio]=hueco->siguiente)==NULL){
+		arena->ultimo[prio]=NULL;
+		cola->u.cola.mapa&=~(1U<<prio);
+	}
+	memcpy(m->buf,hueco->datos,hueco->tam);
+	m->tam=hueco->tam;
+	m->prio=hueco->prio;
+	hueco->siguiente=arena->libres;
+	arena->libres=hueco;
+	cola->u.cola.num--;
+}
+
+/*
+ * Envia los n mensajes del vector en orden, bloqueandose mientras la cola
+ * este llena. Con no_bloquear se para en el primero que no cabe, y si no
+ * ha enviado ninguno devuelve -13. Si se queda llena y nadie mas la tiene
+ * abierta tambien se para, y sin enviar ninguno devuelve -14. Devuelve los
+ * mensajes enviados
+ */
+int enviar_lote(){
+	unsigned int colaid=(unsigned int)leer_registro(1);
+	mensaje *v=(mensaje*)leer_registro(2);
+	int n=(int)leer_registro(3);
+	int no_bloquear=(int)leer_registro(4);
+	mutex *cola;
+	int nivel, i;
+
+	if((cola=obtener_objeto_BCP(p_proc_actual,colaid,OBJ_COLA))==NULL){
+		return -12;
+	}
+	if(v==NULL || n<0){
+		return -1;
+	}
+	for(i=0;i<n;i++){
+		if(v[i].buf==NULL || v[i].tam<0 || v[i].tam>cola->u.cola.max_tam ||
+		   v[i].prio<0 || v[i].prio>=NUM_PRIOS_MSG){
+			return -1;
+		}
+	}
+	nivel=fijar_nivel_int(NIVEL_3);
+	for(i=0;i<n;i++){
+		while(cola->u.cola.num==cola->u.cola.max_msgs && !no_bloquear &&
+		      cola->num_procesos>1){
+			esperar_en_cola(&cola->u.cola.emisores,1);
+		}
+		if(cola->u.cola.num==cola->u.cola.max_msgs){
+			break;
+		}
+		meter_mensaje(cola,&v[i]);
+		despertar_uno(&cola->lista_bloqueados,DESP_EVENTO);
+		notificar_interesados(cola->interesados);
+	}
+	//Si ha quedado sitio, para el siguiente emisor
+	if(cola->u.cola.num<cola->u.cola.max_msgs){
+		despertar_uno(&cola->u.cola.emisores,DESP_EVENTO);
+	}
+	fijar_nivel_int(nivel);
+	if(i==0 && n>0){
+		return no_bloquear ? -13 : -14;
+	}
+	return i;
+}
+
+/*
+ * Recibe hasta n mensajes, de mayor a menor prioridad, en los buffers del
+ * vector, que deben tener sitio para el tamao maximo de la cola. Se
+ * bloquea si la cola esta vacia, salvo con no_bloquear, que devuelve -13.
+ * Devuelve los mensajes recibidos, con su tamao y prioridad, o -14 si
+ * esta vacia y nadie mas la tiene abierta
+ */
+int recibir_lote(){
+	unsigned int colaid=(unsigned int)leer_registro(1);
+	mensaje *v=(mensaje*)leer_registro(2);
+	int n=(int)leer_registro(3);
+	int no_bloquear=(int)leer_registro(4);
+	mutex *cola;
+	int nivel, i;
+
+	if((cola=obtener_objeto_BCP(p_proc_actual,colaid,OBJ_COLA))==NULL){
+		return -12;
+	}
+	if(v==NULL || n<=0){
+		return -1;
+	}
+	for(i=0;i<n;i++){
+		if(v[i].buf==NULL || v[i].tam<cola->u.cola.max_tam){
+			return -1;
+		}
+	}
+	nivel=fijar_nivel_int(NIVEL_3);
+	while(cola->u.cola.num==0){
+		if(no_bloquear){
+			fijar_nivel_int(nivel);
+			return -13;
+		}
+		if(cola->num_procesos==1){
+			fijar_nivel_int(nivel);
+			return -14;
+		}
+		esperar_en_cola(&cola->lista_bloqueados,1);
+	}
+	for(i=0;i<n && cola->u.cola.num>0;i++){
+		sacar_mensaje(cola,&v[i]);
+	}
+	despertar_uno(&cola->u.cola.emisores,DESP_EVENTO);
+	//Si quedan mensajes, para el siguiente receptor
+	if(cola->u.cola.num>0){
+		despertar_uno(&cola->lista_bloqueados,DESP_EVENTO);
+	}
+	fijar_nivel_int(nivel);
+	return i;
+}
+
+/*
+ *
+ * Rutinas de la memoria compartida:
+ *	crear_memoria_compartida abrir_memoria_compartida
+ *
+ * Un segmento es un objeto con nombre de la tabla de mutex cuya memoria
+ * se reserva en el kernel al crearlo, a ceros. Todos los procesos
+ * comparten el espacio de direcciones, asi que proyectarlo es darles la
+ * misma direccion. Se cierra con cerrar_mutex, tambien implicitamente al
+ * terminar, y la memoria se recupera cuando nadie lo tiene abierto.
+ *
+ */
+
+/*
+ * Crea el segmento de tam bytes, deja su direccion en *dir y devuelve el
+ * descriptor
+ */
+int crear_memoria_compartida(){
+	char *nombre=(char*)leer_registro(1);
+	int tam=(int)leer_registro(2);
+	void **dir=(void**)leer_registro(3);
+	int descriptor, tam_bloque=tam;
+	mutex *mem;
+	void *bloque;
+
+	if(nombre==NULL){
+		return -2;
+	}
+	if(dir==NULL || tam<=0 || tam>MAX_TAM_MEMORIA){
+		return -1;
+	}
+	if(cargar_memoria(p_proc_actual,MEM_IPC,tam)<0){
+		return -7;
+	}
+	if((bloque=reservar_bloque(&tam_bloque))==NULL){
+		cargar_memoria(p_proc_actual,MEM_IPC,-tam);
+		return -1;
+	}
+	if((descriptor=crear_objeto(nombre,OBJ_MEMORIA,&mem))<0){
+		devolver_bloque(bloque,tam_bloque);
+		cargar_memoria(p_proc_actual,MEM_IPC,-tam);
+		return descriptor;
+	}
+	cargar_objeto(mem,tam);
+	memset(bloque,0,tam);
+	mem->bloque=bloque;
+	mem->tam_bloque=tam_bloque;
+	mem->u.mem.tam=tam;
+	*dir=bloque;
+	return descriptor;
+}
+
+/*
+ * Abre el segmento, deja su direccion en *dir y devuelve el descriptor
+ */
+int abrir_memoria_compartida(){
+	void **dir=(void**)leer_registro(2);
+	int descriptor;
+
+	if(dir==NULL){
+		return -1;
+	}
+	if((descriptor=abrir_objeto((char*)leer_registro(1),OBJ_MEMORIA))<0){
+		return descriptor;
+	}
+	*dir=obtener_mutex_BCP(p_proc_actual,descriptor)->bloque;
+	return descriptor;
+}
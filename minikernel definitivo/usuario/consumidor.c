@@ -0,0 +1,30 @@
+/*
+ * usuario/consumidor.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de la prueba de los semaforos:
+ * consume dos unidades de una vez
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	int sem, id;
+
+	id=obtener_id_pr();
+
+	if ((sem=abrir_semaforo("s"))<0)
+		printf("error abriendo s. NO DEBE APARECER\n");
+
+	printf("consumidor (%d) espera 2 unidades\n", id);
+	if (sem_esperar(sem, 2)<0)
+		printf("error en sem_esperar. NO DEBE APARECER\n");
+
+	printf("consumidor (%d) obtiene sus unidades y termina\n", id);
+	return 0;
+}
@@ -0,0 +1,36 @@
+/*
+ * usuario/esperador.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de la prueba de las variables
+ * condicion
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	int mut, cond, id;
+
+	id=obtener_id_pr();
+
+	if ((mut=abrir_mutex("mc"))<0)
+		printf("error abriendo mc. NO DEBE APARECER\n");
+
+	if ((cond=abrir_condicion("c"))<0)
+		printf("error abriendo c. NO DEBE APARECER\n");
+
+	lock(mut);
+	printf("esperador (%d) espera en c\n", id);
+	if (esperar_condicion(cond, mut)<0)
+		printf("error en esperar_condicion. NO DEBE APARECER\n");
+	printf("esperador (%d) despierta con mc cogido\n", id);
+	unlock(mut);
+
+	printf("esperador (%d) termina\n", id);
+	return 0;
+}
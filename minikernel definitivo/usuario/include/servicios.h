@@ -21,8 +21,167 @@
 
 /* Evita el uso del printf de la bilioteca estndar */
 #define printf escribirf
+
+/* y el de su memoria dinamica */
+#define malloc reservar_mem
+#define calloc reservar_mem_ceros
+#define realloc cambiar_tam_mem
+#define free liberar_mem
 #define NO_RECURSIVO 0
 #define RECURSIVO 1
+#define PREF_LECTURA 0
+#define PREF_ESCRITURA 1
+#define TIEMPO_TICKS 0
+#define TIEMPO_MONOTONICO 1
+#define TIEMPO_REAL 2
+#define EV_TERMINAL 0
+#define EV_MUTEX 1
+#define EV_TEMPORIZADOR 2
+#define EV_TUBERIA 3
+#define EV_COLA 4
+#define SALIDA_LINEA 0
+#define SALIDA_COMPLETA 1
+#define SALIDA_SIN_BUFFER 2
+#define NUM_PRIOS_MSG 32
+
+/*
+ * Entrada del informe de estadisticas_mutex, con tiempos en ticks de
+ * reloj. Debe coincidir con la definida en minikernel/include/kernel.h
+ */
+typedef struct{
+	char nombre[9];
+	unsigned long adquisiciones;	/* veces que se ha obtenido libre */
+	unsigned long contendidas;	/* adquisiciones que tuvieron que esperar */
+	unsigned long espera_total;
+	unsigned long espera_max;
+	unsigned long retencion_total;
+	unsigned long retencion_max;
+} est_mutex;
+
+/*
+ * Entrada del informe de estadisticas_caches, una por cada cache de
+ * objetos del kernel. Debe coincidir con la definida en
+ * minikernel/include/kernel.h
+ */
+typedef struct{
+	char nombre[12];
+	unsigned long tam;		/* bytes de cada objeto */
+	unsigned long objetos;		/* objetos en los bloques pedidos */
+	unsigned long bloques;
+	unsigned long en_uso;
+	unsigned long max_en_uso;
+	unsigned long reservas;		/* objetos pedidos desde el arranque */
+} est_cache;
+
+/*
+ * Memoria cargada a un proceso, en bytes, que no puede pasar de su
+ * limite. Debe coincidir con la definida en minikernel/include/kernel.h
+ */
+typedef struct{
+	unsigned long en_uso;
+	unsigned long max_en_uso;
+	unsigned long limite;
+	unsigned long pila;
+	unsigned long monticulo;
+	unsigned long ipc;		/* tuberias, colas y segmentos que ha creado */
+	unsigned long fallos;		/* peticiones rechazadas por el limite */
+} est_memoria;
+
+/*
+ * Tope del monticulo de un proceso y trozos en que se le reserva. Deben
+ * coincidir con los definidos en minikernel/include/kernel.h
+ */
+#define MAX_MONTICULO (8<<20)
+#define TROZO_MONTICULO (1<<20)
+
+/* Estado de la memoria dinamica del proceso, en bytes */
+typedef struct{
+	unsigned long en_uso;		/* entregados, redondeados a su bloque */
+	unsigned long max_en_uso;
+	unsigned long reservas;		/* llamadas a malloc atendidas */
+	unsigned long monticulo;	/* pedidos al kernel */
+} est_malloc;
+
+/*
+ * Informe de estadisticas_int, en ciclos del procesador. Debe coincidir
+ * con el definido en minikernel/include/kernel.h
+ */
+#define NUM_VECTORES 6		/* arit, mem, reloj, terminal, llamada, SW */
+#define NUM_CUBOS_INT 16
+#define NUM_VENTANAS 8
+
+typedef struct{
+	unsigned long veces;
+	unsigned long long ciclos_total;
+	unsigned long long ciclos_max;
+	unsigned long histograma[NUM_CUBOS_INT]; /* el cubo i, de menos de 2^(10+i) */
+} est_vector;
+
+/* Tiempo con el reloj inhibido y donde se inhibio */
+typedef struct{
+	char funcion[24];
+	int linea;
+	unsigned long long ciclos;
+} est_ventana;
+
+typedef struct{
+	unsigned long long ciclos_por_tick;
+	est_vector vectores[NUM_VECTORES];
+	est_ventana ventanas[NUM_VENTANAS]; /* de mayor a menor */
+} est_interrupciones;
+
+/*
+ * Traza de eventos del kernel. Categorias, tipos y registro deben
+ * coincidir con los definidos en minikernel/include/kernel.h
+ */
+#define TRAZA_PLANIF 0x01
+#define TRAZA_PROCESOS 0x02
+#define TRAZA_MUTEX 0x04
+#define TRAZA_DORMIR 0x08
+#define TRAZA_INT 0x10
+#define TRAZA_TODO 0x1f
+
+#define TR_SALE 0
+#define TR_ENTRA 1
+#define TR_INACTIVO 2
+#define TR_ACTIVO 3
+#define TR_CREAR 4
+#define TR_TERMINAR 5
+#define TR_PIDE_LOCK 6
+#define TR_LOCK 7
+#define TR_UNLOCK 8
+#define TR_DORMIR 9
+#define TR_DESPERTAR 10
+#define TR_INT_ENTRA 11
+#define TR_INT_SALE 12
+
+typedef struct{
+	unsigned long long ciclos;
+	short tipo;
+	short proc;
+	int dato1;
+	int dato2;
+} registro_traza;
+
+/*
+ * Evento listo que devuelve esperar_eventos. Debe coincidir con el
+ * definido en minikernel/include/kernel.h
+ */
+typedef struct{
+	int id;		/* el que devolvio anadir_evento */
+	int tipo;	/* EV_TERMINAL, EV_MUTEX, EV_TEMPORIZADOR, EV_TUBERIA o EV_COLA */
+}evento;
+
+/*
+ * Mensaje de enviar_lote y recibir_lote. Al recibir, tam es el sitio que
+ * hay en buf y se sustituye por el tamao del mensaje. Debe coincidir con
+ * el definido en minikernel/include/kernel.h
+ */
+typedef struct{
+	char *buf;
+	int tam;
+	int prio;	/* de 0 a NUM_PRIOS_MSG-1, mayor primero */
+}mensaje;
 
 /* Funcion de biblioteca */
 int escribirf(const char *formato, ...);
@@ -38,6 +197,79 @@ int abrir_mutex(char *nombre);
 int cerrar_mutex(unsigned int mutexid);
 int lock(unsigned int mutexid);
 int unlock(unsigned int mutexid);
+int crear_rwlock(char *nombre, int preferencia);
+int abrir_rwlock(char *nombre);
+int lock_lectura(unsigned int rwid);
+int lock_escritura(unsigned int rwid);
+int unlock_rw(unsigned int rwid);
+int crear_condicion(char *nombre);
+int abrir_condicion(char *nombre);
+int esperar_condicion(unsigned int condid, unsigned int mutexid);
+int senalar(unsigned int condid);
+int difundir(unsigned int condid);
+int crear_semaforo(char *nombre, int valor);
+int abrir_semaforo(char *nombre);
+int sem_esperar(unsigned int semid, int n);
+int sem_senalar(unsigned int semid, int n);
+int crear_barrera(char *nombre, int participantes);
+int abrir_barrera(char *nombre);
+int esperar_barrera(unsigned int barid);
+int estadisticas_mutex(est_mutex *tabla, int n);
+int trylock(unsigned int mutexid);
+int lock_temporizado(unsigned int mutexid, int ms);
+int dormir_ms(unsigned int ms);
+int dormir_us(unsigned int us);
+int obtener_tiempo(int tipo, unsigned long long *t);
+/* Periodo 0 la cancela; leer_alarma devuelve las vencidas desde la anterior */
+int alarma(unsigned int periodo_ms);
+int leer_alarma();
+/* Como leer_alarma, pero se bloquea si no ha vencido ninguna */
+int esperar_alarma();
+int leer_caracter();
+int leer(char *buf, int n);
+int crear_eventos();
+int anadir_evento(unsigned int conjid, int tipo, int dato);
+int esperar_eventos(unsigned int conjid, evento *listos, int max, int timeout_ms);
+/* Con nombre nulo la tuberia es anonima y la heredan los procesos que se creen */
+int crear_tuberia(char *nombre);
+int abrir_tuberia(char *nombre);
+int escribir_tuberia(unsigned int tubid, char *buf, int n);
+int leer_tuberia(unsigned int tubid, char *buf, int n);
+int crear_cola(char *nombre, int max_msgs, int max_tam);
+int abrir_cola(char *nombre);
+int enviar_lote(unsigned int colaid, mensaje *v, int n, int no_bloquear);
+int recibir_lote(unsigned int colaid, mensaje *v, int n, int no_bloquear);
+int enviar(unsigned int colaid, char *buf, int tam, int prio);
+int recibir(unsigned int colaid, char *buf, int tam, int *prio);
+/* Devuelven el descriptor y dejan en *dir la direccion del segmento */
+int crear_memoria_compartida(char *nombre, int tam, void **dir);
+int abrir_memoria_compartida(char *nombre, void **dir);
+/* encarnacion puede ser nulo */
+int obtener_pila(void **base, unsigned long *encarnacion);
+int estadisticas_caches(est_cache *tabla, int n);
+/* Como sbrk: deja en *dir el final anterior del monticulo, o el principio
+   de un trozo nuevo si lo pedido no cabe en el ultimo */
+int ampliar_monticulo(int incremento, void **dir);
+/* Solo puede bajarlo; lo heredan los procesos que se creen */
+int limitar_memoria(unsigned long limite);
+/* Con pid negativo, la del proceso que llama */
+int estadisticas_memoria(int pid, est_memoria *e);
+int estadisticas_int(est_interrupciones *e, int reiniciar);
+/* Devuelve las categorias que estaban activadas */
+int activar_traza(unsigned int categorias);
+/* Saca hasta n registros; en *perdidos, los pisados desde la anterior */
+int leer_traza(registro_traza *v, int n, unsigned long *perdidos);
+
+/* Salida con buffer de escribir y printf */
+int modo_salida(int modo);
+int vaciar_salida();
+
+/* Memoria dinamica */
+void *malloc(unsigned long tam);
+void *calloc(unsigned long n, unsigned long tam);
+void *realloc(void *p, unsigned long tam);
+void free(void *p);
+int estadisticas_malloc(est_malloc *e);
 
 #endif /* SERVICIOS_H */
 
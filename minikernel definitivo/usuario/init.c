@@ -69,6 +69,126 @@ ALGO COMENTE ESTA PARTE Y DESCOMENTE LA PRUEBA CORRESPONDIENTE */
 		printf("Error creando prueba_mutex2\n");
 */
 
+/* PRUEBA DE TABLAS DE MUTEX DINMICAS
+	if (crear_proceso("muchos_mutex")<0)
+		printf("Error creando muchos_mutex\n");
+*/
+
+/* PRUEBA DE RWLOCK
+	if (crear_proceso("prueba_rwlock")<0)
+		printf("Error creando prueba_rwlock\n");
+*/
+
+/* PRUEBA DE VARIABLES CONDICION
+	if (crear_proceso("prueba_condicion")<0)
+		printf("Error creando prueba_condicion\n");
+*/
+
+/* PRUEBA DE SEMAFOROS
+	if (crear_proceso("prueba_semaforo")<0)
+		printf("Error creando prueba_semaforo\n");
+*/
+
+/* PRUEBA DE BARRERAS
+	if (crear_proceso("prueba_barrera")<0)
+		printf("Error creando prueba_barrera\n");
+*/
+
+/* PRUEBA DEL PERFIL DE MUTEX
+	if (crear_proceso("prueba_perfil")<0)
+		printf("Error creando prueba_perfil\n");
+*/
+
+/* PRUEBA DE TRYLOCK Y LOCK_TEMPORIZADO
+	if (crear_proceso("prueba_trylock")<0)
+		printf("Error creando prueba_trylock\n");
+*/
+
+/* PRUEBA DE DORMIR_MS Y DORMIR_US
+	if (crear_proceso("prueba_dormir_ms")<0)
+		printf("Error creando prueba_dormir_ms\n");
+*/
+
+/* PRUEBA DE OBTENER_TIEMPO
+	if (crear_proceso("prueba_tiempo")<0)
+		printf("Error creando prueba_tiempo\n");
+*/
+
+/* PRUEBA DE ALARMAS PERIODICAS
+	if (crear_proceso("prueba_alarma")<0)
+		printf("Error creando prueba_alarma\n");
+*/
+
+/* PRUEBA DE LECTURA EN BLOQUE DEL TERMINAL
+	if (crear_proceso("prueba_leer")<0)
+		printf("Error creando prueba_leer\n");
+*/
+
+/* PRUEBA DE CONJUNTOS DE EVENTOS
+	if (crear_proceso("prueba_eventos")<0)
+		printf("Error creando prueba_eventos\n");
+*/
+
+/* PRUEBA DE TUBERIAS
+	if (crear_proceso("prueba_tuberia")<0)
+		printf("Error creando prueba_tuberia\n");
+*/
+
+/* PRUEBA DE COLAS DE MENSAJES
+	if (crear_proceso("prueba_cola")<0)
+		printf("Error creando prueba_cola\n");
+*/
+
+/* PRUEBA DE MEMORIA COMPARTIDA
+	if (crear_proceso("prueba_memoria")<0)
+		printf("Error creando prueba_memoria\n");
+*/
+
+/* PRUEBA DE LA SALIDA CON BUFFER
+	if (crear_proceso("prueba_salida")<0)
+		printf("Error creando prueba_salida\n");
+*/
+
+/* PRUEBA DE LINEAS ENTERAS EN LA CONSOLA
+	if (crear_proceso("prueba_consola")<0)
+		printf("Error creando prueba_consola\n");
+*/
+
+/* PRUEBA DE LAS CACHES DE OBJETOS DEL KERNEL
+	if (crear_proceso("prueba_caches")<0)
+		printf("Error creando prueba_caches\n");
+*/
+
+/* PRUEBA DE LA MEMORIA DINAMICA
+	if (crear_proceso("prueba_malloc")<0)
+		printf("Error creando prueba_malloc\n");
+*/
+
+/* PRUEBA DEL LIMITE DE MEMORIA
+	if (crear_proceso("prueba_limite")<0)
+		printf("Error creando prueba_limite\n");
+*/
+
+/* PRUEBA DE LAS MITADES INFERIORES
+	if (crear_proceso("prueba_mitades")<0)
+		printf("Error creando prueba_mitades\n");
+*/
+
+/* PRUEBA DE LA MEDIDA DE INTERRUPCIONES
+	if (crear_proceso("prueba_int")<0)
+		printf("Error creando prueba_int\n");
+*/
+
+/* TRAZA DE EVENTOS DEL KERNEL EN JSON
+	if (crear_proceso("volcar_traza")<0)
+		printf("Error creando volcar_traza\n");
+*/
+
+/* PRUEBA DE DIFUNDIR CUANDO MUERE EL PRIMERO EN DESPERTAR
+	if (crear_proceso("prueba_difundir")<0)
+		printf("Error creando prueba_difundir\n");
+*/
+
 /* PRIMERA PRUEBA DE ROUND-ROBIN
 	if (crear_proceso("prueba_RR1")<0)
 		printf("Error creando prueba_RR1\n");
@@ -0,0 +1,39 @@
+/*
+ * usuario/lector_rw.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de la prueba de los rwlock
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	int desc, id;
+
+	id=obtener_id_pr();
+	printf("lector_rw (%d) comienza\n", id);
+
+	if ((desc=abrir_rwlock("rw"))<0)
+		printf("error abriendo rw. NO DEBE APARECER\n");
+
+	if (lock_lectura(desc)<0)
+		printf("error en lock_lectura. NO DEBE APARECER\n");
+
+	/* segundo lock de lectura del mismo proceso -> error */
+	if (lock_lectura(desc)<0)
+		printf("lector_rw (%d): segundo lock_lectura. DEBE APARECER\n", id);
+
+	printf("lector_rw (%d) lee y duerme 1 seg.\n", id);
+	dormir(1);
+
+	if (unlock_rw(desc)<0)
+		printf("error en unlock_rw. NO DEBE APARECER\n");
+
+	printf("lector_rw (%d) termina\n", id);
+	return 0;
+}
@@ -17,6 +17,7 @@
  */
 
 #include "llamsis.h"
+#include "const.h"
 #include "servicios.h"
 
 /* Funcin del mdulo "misc" que prepara el cdigo de la llamada
@@ -26,6 +27,353 @@
 
 int llamsis(int llamada, int nargs, ... /* args */);
 
+/*
+ *
+ * Salida con buffer: escribir (y printf, que la usa) acumula el texto en
+ * un buffer del proceso y solo hace la llamada al sistema al vaciarlo.
+ * En modo SALIDA_LINEA se vacia al escribir un fin de linea, en
+ * SALIDA_COMPLETA cuando se llena y en SALIDA_SIN_BUFFER siempre. Se
+ * vacia tambien con vaciar_salida, antes de leer del terminal y al
+ * terminar el proceso, incluida la vuelta de main.
+ *
+ * Los procesos de un mismo programa comparten sus variables globales, asi
+ * que hay un buffer por identificador de proceso. El proceso pregunta al
+ * kernel su identificador y su encarnacion con obtener_pila; si la entrada
+ * de su identificador es de otra encarnacion, la de un proceso que ya
+ * termino, incluso sin llamar a terminar_proceso, se reinicia y no hereda
+ * asi su estado.
+ *
+ */
+
+#define TAM_BUF_SALIDA 512
+
+static struct salida{
+	int modo;
+	int num;		/* bytes pendientes */
+	char buf[TAM_BUF_SALIDA];
+} salidas[MAX_PROC];
+
+static unsigned long encarnaciones[MAX_PROC];	/* duena de cada entrada, 0 si ninguna */
+
+static int con_monticulo[MAX_PROC];	/* 1 si ya ha iniciado su monticulo */
+
+static int escribir_directo(char *texto, unsigned int longi){
+	return llamsis(ESCRIBIR, 2, (long)texto, (long)longi);
+}
+
+/* Identificador del proceso que llama, o -1 si no se puede saber */
+static int mi_id(){
+	void *pila;
+	unsigned long encarnacion;
+	int i;
+
+	if ((i=obtener_pila(&pila, &encarnacion))<0 || i>=MAX_PROC)
+		return -1;
+	if (encarnaciones[i]==encarnacion)
+		return i;
+	encarnaciones[i]=encarnacion;
+	salidas[i].modo=SALIDA_LINEA;
+	salidas[i].num=0;
+	con_monticulo[i]=0;
+	return i;
+}
+
+/* Buffer del proceso que llama, o NULL si no se puede saber */
+static struct salida *mi_salida(){
+	int id=mi_id();
+
+	return id<0 ? NULL : &salidas[id];
+}
+
+static void vaciar(struct salida *s){
+	if (s->num>0)
+		escribir_directo(s->buf, s->num);
+	s->num=0;
+}
+
+int vaciar_salida(){
+	struct salida *s=mi_salida();
+
+	if (s)
+		vaciar(s);
+	return 0;
+}
+
+int modo_salida(int modo){
+	struct salida *s=mi_salida();
+
+	if (s==NULL || modo<SALIDA_LINEA || modo>SALIDA_SIN_BUFFER)
+		return -1;
+	vaciar(s);
+	s->modo=modo;
+	return 0;
+}
+
+
+/*
+ *
+ * Memoria dinamica: malloc, calloc, realloc y free, que servicios.h
+ * renombra para no usar las de la biblioteca estandar.
+ *
+ * Cada proceso tiene su monticulo, que pide al kernel con
+ * ampliar_monticulo en trozos de TROZO_MONTICULO bytes, que no tienen por
+ * que estar seguidos. El estado del reparto y el mapa de paginas de cada
+ * trozo estan aqui, y los trozos se reparten por el sistema buddy en
+ * bloques de una pagina a un trozo entero, sin salirse del trozo. Los
+ * objetos de hasta TAM_MAX_CLASE bytes salen de paginas partidas en
+ * clases de tamao potencia de 2, con una lista de libres por clase y
+ * proceso que no toca el buddy salvo para pedir una pagina nueva. Esas
+ * paginas no vuelven al buddy.
+ *
+ */
+
+#define ORDEN_PAGINA 12
+#define TAM_PAGINA_MEM (1<<ORDEN_PAGINA)
+#define NUM_ORDENES 9			/* bloques de 4KB a 1MB, un trozo */
+#define TAM_TROZO TROZO_MONTICULO
+#define MAX_TROZOS (MAX_MONTICULO/TAM_TROZO)
+#define PAGS_TROZO (TAM_TROZO/TAM_PAGINA_MEM)
+#define NUM_CLASES 8			/* objetos de 16 a 2048 bytes */
+#define TAM_MIN_CLASE 16
+#define TAM_MAX_CLASE (TAM_MIN_CLASE<<(NUM_CLASES-1))
+#define PAG_LIBRE 0x40			/* en el mapa: bloque libre, con su orden */
+#define PAG_CLASE 0x80			/* en el mapa: pagina de objetos, con su clase */
+
+struct libre_buddy{
+	struct libre_buddy *siguiente;
+	struct libre_buddy *anterior;
+};
+
+struct monticulo{
+	struct libre_buddy libres[NUM_ORDENES];	/* listas circulares por orden */
+	void *clases[NUM_CLASES];	/* objetos libres de cada clase */
+	char *trozos[MAX_TROZOS];	/* principio de cada trozo */
+	int num_trozos;
+	unsigned long en_uso;
+	unsigned long max_en_uso;
+	unsigned long reservas;
+	/* por pagina: orden de un bloque ocupado que empieza en ella,
+	   PAG_LIBRE|orden de uno libre o PAG_CLASE|clase */
+	unsigned char mapa[MAX_TROZOS][PAGS_TROZO];
+};
+
+static struct monticulo monticulos[MAX_PROC];
+
+/* Trozo en que esta b */
+static int trozo_de(struct monticulo *m, char *b){
+	int k;
+
+	for (k=0; k<m->num_trozos-1; k++)
+		if (b>=m->trozos[k] && b<m->trozos[k]+TAM_TROZO)
+			break;
+	return k;
+}
+
+/* Entrada del mapa de la pagina en que empieza b */
+static unsigned char *entrada_mapa(struct monticulo *m, char *b){
+	int k=trozo_de(m, b);
+
+	return &m->mapa[k][(b-m->trozos[k])>>ORDEN_PAGINA];
+}
+
+static void meter_libre(struct monticulo *m, char *b, int orden){
+	struct libre_buddy *l=(struct libre_buddy *)b, *cab=&m->libres[orden];
+
+	l->siguiente=cab->siguiente;
+	l->anterior=cab;
+	cab->siguiente->anterior=l;
+	cab->siguiente=l;
+	*entrada_mapa(m, b)=PAG_LIBRE|orden;
+}
+
+static void sacar_libre(struct monticulo *m, char *b){
+	struct libre_buddy *l=(struct libre_buddy *)b;
+
+	l->anterior->siguiente=l->siguiente;
+	l->siguiente->anterior=l->anterior;
+	*entrada_mapa(m, b)=0;
+}
+
+/* Monticulo del proceso que llama, que se inicia la primera vez */
+static struct monticulo *mi_monticulo(){
+	struct monticulo *m;
+	unsigned long j;
+	int id, i;
+
+	if ((id=mi_id())<0)
+		return NULL;
+	m=&monticulos[id];
+	if (con_monticulo[id])
+		return m;
+	/* puede quedar el de otro proceso que tuvo este identificador */
+	for (j=0; j<sizeof(struct monticulo); j++)
+		((char *)m)[j]=0;
+	for (i=0; i<NUM_ORDENES; i++)
+		m->libres[i].siguiente=m->libres[i].anterior=&m->libres[i];
+	con_monticulo[id]=1;
+	return m;
+}
+
+/* Saca un bloque de 2^orden paginas, partiendo uno mayor si hace falta */
+static char *reservar_buddy(struct monticulo *m, int orden){
+	struct libre_buddy *l;
+	char *b;
+	int o;
+
+	for (o=orden; o<NUM_ORDENES; o++)
+		if (m->libres[o].siguiente!=&m->libres[o])
+			break;
+	if (o==NUM_ORDENES) {
+		if (m->num_trozos==MAX_TROZOS ||
+		    ampliar_monticulo(TAM_TROZO, (void **)&b)<0)
+			return NULL;
+		m->trozos[m->num_trozos++]=b;
+		o=NUM_ORDENES-1;
+	}
+	else {
+		l=m->libres[o].siguiente;
+		b=(char *)l;
+		sacar_libre(m, b);
+	}
+	while (o>orden) {
+		o--;
+		meter_libre(m, b+(TAM_PAGINA_MEM<<o), o);
+	}
+	*entrada_mapa(m, b)=orden;
+	return b;
+}
+
+/*
+ * Devuelve un bloque, juntandolo con su pareja mientras este libre. La
+ * pareja siempre esta en el mismo trozo
+ */
+static void liberar_buddy(struct monticulo *m, char *b, int orden){
+	int k=trozo_de(m, b);
+	unsigned long desp=b-m->trozos[k], pareja;
+
+	while (orden<NUM_ORDENES-1) {
+		pareja=desp^((unsigned long)TAM_PAGINA_MEM<<orden);
+		if (m->mapa[k][pareja>>ORDEN_PAGINA]!=(PAG_LIBRE|orden))
+			break;
+		sacar_libre(m, m->trozos[k]+pareja);
+		if (pareja<desp)
+			desp=pareja;
+		orden++;
+	}
+	meter_libre(m, m->trozos[k]+desp, orden);
+}
+
+/* Bytes que ocupa realmente el bloque de p */
+static unsigned long tam_bloque(struct monticulo *m, void *p){
+	int marca=*entrada_mapa(m, p);
+
+	if (marca&PAG_CLASE)
+		return TAM_MIN_CLASE<<(marca&~PAG_CLASE);
+	return (unsigned long)TAM_PAGINA_MEM<<marca;
+}
+
+static void anotar_uso(struct monticulo *m, long tam){
+	m->en_uso+=tam;
+	if (m->en_uso>m->max_en_uso)
+		m->max_en_uso=m->en_uso;
+}
+
+void *malloc(unsigned long tam){
+	struct monticulo *m;
+	char *pag, *p;
+	int clase, orden, i;
+
+	if (tam==0 || tam>TAM_TROZO || (m=mi_monticulo())==NULL)
+		return NULL;
+	if (tam<=TAM_MAX_CLASE) {
+		for (clase=0; (unsigned long)(TAM_MIN_CLASE<<clase)<tam; clase++)
+			;
+		if (m->clases[clase]==NULL) {
+			if ((pag=reservar_buddy(m, 0))==NULL)
+				return NULL;
+			*entrada_mapa(m, pag)=PAG_CLASE|clase;
+			for (i=TAM_PAGINA_MEM-(TAM_MIN_CLASE<<clase); i>=0;
+			     i-=TAM_MIN_CLASE<<clase) {
+				*(void **)(pag+i)=m->clases[clase];
+				m->clases[clase]=pag+i;
+			}
+		}
+		p=m->clases[clase];
+		m->clases[clase]=*(void **)p;
+	}
+	else {
+		for (orden=0; (unsigned long)(TAM_PAGINA_MEM<<orden)<tam; orden++)
+			;
+		if ((p=reservar_buddy(m, orden))==NULL)
+			return NULL;
+	}
+	m->reservas++;
+	anotar_uso(m, tam_bloque(m, p));
+	return p;
+}
+
+void free(void *p){
+	struct monticulo *m;
+	int marca;
+
+	if (p==NULL || (m=mi_monticulo())==NULL)
+		return;
+	m->en_uso-=tam_bloque(m, p);
+	marca=*entrada_mapa(m, p);
+	if (marca&PAG_CLASE) {
+		*(void **)p=m->clases[marca&~PAG_CLASE];
+		m->clases[marca&~PAG_CLASE]=p;
+	}
+	else
+		liberar_buddy(m, p, marca);
+}
+
+void *calloc(unsigned long n, unsigned long tam){
+	char *p;
+	unsigned long i;
+
+	if (tam && n>TAM_TROZO/tam)
+		return NULL;
+	if ((p=malloc(n*tam))!=NULL)
+		for (i=0; i<n*tam; i++)
+			p[i]=0;
+	return p;
+}
+
+void *realloc(void *p, unsigned long tam){
+	struct monticulo *m;
+	unsigned long viejo, i;
+	char *nuevo;
+
+	if (p==NULL)
+		return malloc(tam);
+	if (tam==0) {
+		free(p);
+		return NULL;
+	}
+	if ((m=mi_monticulo())==NULL)
+		return NULL;
+	if ((viejo=tam_bloque(m, p))>=tam)
+		return p;
+	if ((nuevo=malloc(tam))==NULL)
+		return NULL;
+	for (i=0; i<viejo; i++)
+		nuevo[i]=((char *)p)[i];
+	free(p);
+	return nuevo;
+}
+
+int estadisticas_malloc(est_malloc *e){
+	struct monticulo *m;
+
+	if (e==NULL || (m=mi_monticulo())==NULL)
+		return -1;
+	e->en_uso=m->en_uso;
+	e->max_en_uso=m->max_en_uso;
+	e->reservas=m->reservas;
+	e->monticulo=(unsigned long)m->num_trozos*TAM_TROZO;
+	return 0;
+}
 
 /*
  *
@@ -38,29 +386,218 @@ int crear_proceso(char *prog){
 	return llamsis(CREAR_PROCESO, 1, (long)prog);
 }
 int terminar_proceso(){
+	vaciar_salida();
 	return llamsis(TERMINAR_PROCESO, 0);
 }
 int escribir(char *texto, unsigned int longi){
-	return llamsis(ESCRIBIR, 2, (long)texto, (long)longi);
+	struct salida *s=mi_salida();
+	unsigned int i;
+	int linea=0;
+
+	if (s==NULL || s->modo==SALIDA_SIN_BUFFER)
+		return escribir_directo(texto, longi);
+	if (s->num+longi>TAM_BUF_SALIDA) {
+		vaciar(s);
+		if (longi>TAM_BUF_SALIDA)
+			return escribir_directo(texto, longi);
+	}
+	for (i=0; i<longi; i++)
+		if ((s->buf[s->num++]=texto[i])=='\n')
+			linea=1;
+	if ((linea && s->modo==SALIDA_LINEA) || s->num==TAM_BUF_SALIDA)
+		vaciar(s);
+	return 0;
 }
 int obtener_id_pr(){
-	return llamsis(OBTENER_ID_PR,3);
+	return llamsis(OBTENER_ID_PR, 0);
 }
 int dormir(unsigned int segundos){
-	return llamsis(DORMIR, 4, (long)segundos);
+	return llamsis(DORMIR, 1, (long)segundos);
 }
 int crear_mutex(char *nombre, int tipo){
-	return llamsis(CREAR_MUTEX, 5,(long)nombre,(long)tipo);
+	return llamsis(CREAR_MUTEX, 2, (long)nombre,(long)tipo);
 }
 int abrir_mutex(char *nombre){
-	return llamsis(ABRIR_MUTEX, 6, (long)nombre);
+	return llamsis(ABRIR_MUTEX, 1, (long)nombre);
 }
 int cerrar_mutex(unsigned int mutexid){
-	return llamsis(CERRAR_MUTEX, 7,(long)mutexid);
+	return llamsis(CERRAR_MUTEX, 1, (long)mutexid);
 }
 int lock(unsigned int mutexid){
-	return llamsis(LOCK, 8,(long)mutexid);
+	return llamsis(LOCK, 1, (long)mutexid);
 }
 int unlock(unsigned int mutexid){
-	return llamsis(UNLOCK, 9,(long)mutexid);
-}
\ No newline at end of file
+	return llamsis(UNLOCK, 1, (long)mutexid);
+}
+int crear_rwlock(char *nombre, int preferencia){
+	return llamsis(CREAR_RWLOCK, 2, (long)nombre, (long)preferencia);
+}
+int abrir_rwlock(char *nombre){
+	return llamsis(ABRIR_RWLOCK, 1, (long)nombre);
+}
+int lock_lectura(unsigned int rwid){
+	return llamsis(LOCK_LECTURA, 1, (long)rwid);
+}
+int lock_escritura(unsigned int rwid){
+	return llamsis(LOCK_ESCRITURA, 1, (long)rwid);
+}
+int unlock_rw(unsigned int rwid){
+	return llamsis(UNLOCK_RW, 1, (long)rwid);
+}
+int crear_condicion(char *nombre){
+	return llamsis(CREAR_CONDICION, 1, (long)nombre);
+}
+int abrir_condicion(char *nombre){
+	return llamsis(ABRIR_CONDICION, 1, (long)nombre);
+}
+int esperar_condicion(unsigned int condid, unsigned int mutexid){
+	return llamsis(ESPERAR_CONDICION, 2, (long)condid, (long)mutexid);
+}
+int senalar(unsigned int condid){
+	return llamsis(SENALAR, 1, (long)condid);
+}
+int difundir(unsigned int condid){
+	return llamsis(DIFUNDIR, 1, (long)condid);
+}
+int crear_semaforo(char *nombre, int valor){
+	return llamsis(CREAR_SEMAFORO, 2, (long)nombre, (long)valor);
+}
+int abrir_semaforo(char *nombre){
+	return llamsis(ABRIR_SEMAFORO, 1, (long)nombre);
+}
+int sem_esperar(unsigned int semid, int n){
+	return llamsis(SEM_ESPERAR, 2, (long)semid, (long)n);
+}
+int sem_senalar(unsigned int semid, int n){
+	return llamsis(SEM_SENALAR, 2, (long)semid, (long)n);
+}
+int crear_barrera(char *nombre, int participantes){
+	return llamsis(CREAR_BARRERA, 2, (long)nombre, (long)participantes);
+}
+int abrir_barrera(char *nombre){
+	return llamsis(ABRIR_BARRERA, 1, (long)nombre);
+}
+int esperar_barrera(unsigned int barid){
+	return llamsis(ESPERAR_BARRERA, 1, (long)barid);
+}
+int estadisticas_mutex(est_mutex *tabla, int n){
+	return llamsis(ESTADISTICAS_MUTEX, 2, (long)tabla, (long)n);
+}
+int trylock(unsigned int mutexid){
+	return llamsis(TRYLOCK, 1, (long)mutexid);
+}
+int lock_temporizado(unsigned int mutexid, int ms){
+	return llamsis(LOCK_TEMPORIZADO, 2, (long)mutexid, (long)ms);
+}
+int dormir_ms(unsigned int ms){
+	return llamsis(DORMIR_MS, 1, (long)ms);
+}
+int dormir_us(unsigned int us){
+	return llamsis(DORMIR_US, 1, (long)us);
+}
+int obtener_tiempo(int tipo, unsigned long long *t){
+	return llamsis(OBTENER_TIEMPO, 2, (long)tipo, (long)t);
+}
+int alarma(unsigned int periodo_ms){
+	return llamsis(ALARMA, 1, (long)periodo_ms);
+}
+int leer_alarma(){
+	return llamsis(LEER_ALARMA, 0);
+}
+int esperar_alarma(){
+	return llamsis(ESPERAR_ALARMA, 0);
+}
+int leer_caracter(){
+	vaciar_salida();
+	return llamsis(LEER_CARACTER, 0);
+}
+int leer(char *buf, int n){
+	vaciar_salida();
+	return llamsis(LEER, 2, (long)buf, (long)n);
+}
+int crear_eventos(){
+	return llamsis(CREAR_EVENTOS, 0);
+}
+int anadir_evento(unsigned int conjid, int tipo, int dato){
+	return llamsis(ANADIR_EVENTO, 3, (long)conjid, (long)tipo, (long)dato);
+}
+int esperar_eventos(unsigned int conjid, evento *listos, int max, int timeout_ms){
+	return llamsis(ESPERAR_EVENTOS, 4, (long)conjid, (long)listos, (long)max, (long)timeout_ms);
+}
+int crear_tuberia(char *nombre){
+	return llamsis(CREAR_TUBERIA, 1, (long)nombre);
+}
+int abrir_tuberia(char *nombre){
+	return llamsis(ABRIR_TUBERIA, 1, (long)nombre);
+}
+int escribir_tuberia(unsigned int tubid, char *buf, int n){
+	return llamsis(ESCRIBIR_TUBERIA, 3, (long)tubid, (long)buf, (long)n);
+}
+int leer_tuberia(unsigned int tubid, char *buf, int n){
+	return llamsis(LEER_TUBERIA, 3, (long)tubid, (long)buf, (long)n);
+}
+int crear_cola(char *nombre, int max_msgs, int max_tam){
+	return llamsis(CREAR_COLA, 3, (long)nombre, (long)max_msgs, (long)max_tam);
+}
+int abrir_cola(char *nombre){
+	return llamsis(ABRIR_COLA, 1, (long)nombre);
+}
+int enviar_lote(unsigned int colaid, mensaje *v, int n, int no_bloquear){
+	return llamsis(ENVIAR_LOTE, 4, (long)colaid, (long)v, (long)n, (long)no_bloquear);
+}
+int recibir_lote(unsigned int colaid, mensaje *v, int n, int no_bloquear){
+	return llamsis(RECIBIR_LOTE, 4, (long)colaid, (long)v, (long)n, (long)no_bloquear);
+}
+/* enviar y recibir son lotes de un mensaje que se bloquean */
+int enviar(unsigned int colaid, char *buf, int tam, int prio){
+	mensaje m;
+	int res;
+
+	m.buf=buf;
+	m.tam=tam;
+	m.prio=prio;
+	res=enviar_lote(colaid, &m, 1, 0);
+	return res<0 ? res : 0;
+}
+int recibir(unsigned int colaid, char *buf, int tam, int *prio){
+	mensaje m;
+	int res;
+
+	m.buf=buf;
+	m.tam=tam;
+	if ((res=recibir_lote(colaid, &m, 1, 0))<0)
+		return res;
+	if (prio)
+		*prio=m.prio;
+	return m.tam;
+}
+int crear_memoria_compartida(char *nombre, int tam, void **dir){
+	return llamsis(CREAR_MEMORIA_COMPARTIDA, 3, (long)nombre, (long)tam, (long)dir);
+}
+int abrir_memoria_compartida(char *nombre, void **dir){
+	return llamsis(ABRIR_MEMORIA_COMPARTIDA, 2, (long)nombre, (long)dir);
+}
+int obtener_pila(void **base, unsigned long *encarnacion){
+	return llamsis(OBTENER_PILA, 2, (long)base, (long)encarnacion);
+}
+int estadisticas_caches(est_cache *tabla, int n){
+	return llamsis(ESTADISTICAS_CACHES, 2, (long)tabla, (long)n);
+}
+int ampliar_monticulo(int incremento, void **dir){
+	return llamsis(AMPLIAR_MONTICULO, 2, (long)incremento, (long)dir);
+}
+int limitar_memoria(unsigned long limite){
+	return llamsis(LIMITAR_MEMORIA, 1, (long)limite);
+}
+int estadisticas_memoria(int pid, est_memoria *e){
+	return llamsis(ESTADISTICAS_MEMORIA, 2, (long)pid, (long)e);
+}
+int estadisticas_int(est_interrupciones *e, int reiniciar){
+	return llamsis(ESTADISTICAS_INT, 2, (long)e, (long)reiniciar);
+}
+int activar_traza(unsigned int categorias){
+	return llamsis(ACTIVAR_TRAZA, 1, (long)categorias);
+}
+int leer_traza(registro_traza *v, int n, unsigned long *perdidos){
+	return llamsis(LEER_TRAZA, 3, (long)v, (long)n, (long)perdidos);
+}
@@ -0,0 +1,53 @@
+/*
+ * usuario/muchos_mutex.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba que las tablas de mutex crecen bajo
+ * demanda: crea, usa y cierra muchos ms mutex que NUM_MUT y NUM_MUT_PROC
+ */
+
+#include "servicios.h"
+
+#define TOT_MUTEX 200
+
+int main(){
+	char nombre[8];
+	int desc[TOT_MUTEX];
+	int i, errores=0;
+
+	printf("muchos_mutex: comienza\n");
+
+	for (i=0; i<TOT_MUTEX; i++) {
+		nombre[0]='n';
+		nombre[1]='0'+i/100;
+		nombre[2]='0'+(i/10)%10;
+		nombre[3]='0'+i%10;
+		nombre[4]='\0';
+		if ((desc[i]=crear_mutex(nombre, NO_RECURSIVO))<0)
+			errores++;
+	}
+	printf("muchos_mutex: creados %d mutex con %d errores. DEBE HABER 0 ERRORES\n",
+		TOT_MUTEX, errores);
+
+	for (i=0; i<TOT_MUTEX; i++)
+		if (lock(desc[i])<0 || unlock(desc[i])<0)
+			errores++;
+	printf("muchos_mutex: lock y unlock de todos con %d errores. DEBE HABER 0 ERRORES\n",
+		errores);
+
+	/* cierra la mitad: sus descriptores deben reutilizarse */
+	for (i=0; i<TOT_MUTEX; i+=2)
+		cerrar_mutex(desc[i]);
+
+	if (crear_mutex("otro", NO_RECURSIVO)!=desc[0])
+		printf("muchos_mutex: no se reutiliza el descriptor libre. NO DEBE SALIR\n");
+
+	printf("muchos_mutex: termina\n");
+
+	/* cierre implcito del resto de mutex */
+	return 0;
+}
@@ -0,0 +1,35 @@
+/*
+ * usuario/perfil_mutex.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que muestra los mutex abiertos con ms contencin,
+ * de mayor a menor tiempo de espera acumulado. Los tiempos son ticks de
+ * reloj.
+ *
+ */
+
+#include "servicios.h"
+
+#define NUM_MOSTRADOS 8
+
+int main(){
+	est_mutex tabla[NUM_MOSTRADOS];
+	int i, n;
+
+	if ((n=estadisticas_mutex(tabla, NUM_MOSTRADOS))<0) {
+		printf("perfil_mutex: error obteniendo estadisticas\n");
+		return 1;
+	}
+	printf("%-8s %6s %6s %8s %6s %8s %6s\n", "mutex", "adq", "cont",
+		"esp_tot", "esp_mx", "ret_tot", "ret_mx");
+	for (i=0; i<n; i++)
+		printf("%-8s %6lu %6lu %8lu %6lu %8lu %6lu\n", tabla[i].nombre,
+			tabla[i].adquisiciones, tabla[i].contendidas,
+			tabla[i].espera_total, tabla[i].espera_max,
+			tabla[i].retencion_total, tabla[i].retencion_max);
+	return 0;
+}
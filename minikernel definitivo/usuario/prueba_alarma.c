@@ -0,0 +1,59 @@
+/*
+ * usuario/prueba_alarma.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de las alarmas peridicas.
+ * Las alarmas no interrumpen al proceso: este consulta con leer_alarma
+ * cuntas han vencido, o espera a la siguiente con esperar_alarma.
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	volatile long i;
+	int recibidas=0, vencidas;
+
+	printf("prueba_alarma comienza\n");
+
+	if (esperar_alarma()<0)
+		printf("esperar_alarma sin alarma programada. DEBE APARECER\n");
+
+	if (alarma(100)<0)
+		printf("error programando la alarma. NO DEBE APARECER\n");
+
+	/* vencen mientras calcula, aunque no haga llamadas */
+	while (recibidas<3) {
+		for (i=0; i<100000; i++);
+		recibidas+=leer_alarma();
+	}
+	printf("prueba_alarma cuenta 3 alarmas mientras calcula\n");
+
+	/* bloqueado, sin perder ninguna */
+	leer_alarma();
+	for (i=0; i<5; i++)
+		if ((vencidas=esperar_alarma())!=1)
+			printf("esperar_alarma devuelve %d. NO DEBE APARECER\n", vencidas);
+	printf("prueba_alarma espera 5 alarmas de una en una\n");
+
+	/* justo tras una, dormido 1 seg. vencen unas 10 de una vez */
+	esperar_alarma();
+	dormir(1);
+	vencidas=leer_alarma();
+	printf("al despertar: %d vencidas: deben ser entre 9 y 11\n", vencidas);
+	if (vencidas<9 || vencidas>11)
+		printf("numero de vencidas fuera de rango. NO DEBE APARECER\n");
+	if (leer_alarma()!=0)
+		printf("la cuenta no se ha puesto a cero. NO DEBE APARECER\n");
+
+	alarma(0);
+	dormir_ms(300);
+	printf("tras cancelarla: %d vencidas: debe ser 0\n", leer_alarma());
+
+	printf("prueba_alarma termina\n");
+	return 0;
+}
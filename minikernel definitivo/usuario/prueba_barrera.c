@@ -0,0 +1,34 @@
+/*
+ * usuario/prueba_barrera.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de las barreras
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+
+	printf("prueba_barrera comienza\n");
+
+	if (crear_barrera("b", 3)<0)
+		printf("error creando b. NO DEBE APARECER\n");
+
+	if (crear_proceso("trabajador")<0)
+		printf("Error creando trabajador\n");
+	if (crear_proceso("trabajador")<0)
+		printf("Error creando trabajador\n");
+	if (crear_proceso("trabajador")<0)
+		printf("Error creando trabajador\n");
+
+	/* mantiene la barrera abierta mientras trabajan */
+	dormir(3);
+
+	printf("prueba_barrera termina\n");
+	return 0;
+}
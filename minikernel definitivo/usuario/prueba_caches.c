@@ -0,0 +1,83 @@
+/*
+ * usuario/prueba_caches.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba las caches de objetos del kernel. Crea
+ * y cierra dos tandas de mutex: la segunda debe reutilizar los objetos
+ * de la primera sin que la cache pida mas bloques.
+ *
+ */
+
+#include "servicios.h"
+
+#define NUM_CACHES 8
+#define TANDA 100
+
+static est_cache tabla[NUM_CACHES];
+
+static void mostrar(char *momento){
+	int i, n;
+
+	n=estadisticas_caches(tabla, NUM_CACHES);
+	printf("prueba_caches: %s\n", momento);
+	for (i=0; i<n; i++)
+		printf("  %s: tam %d objetos %d bloques %d en uso %d max %d reservas %d\n",
+			tabla[i].nombre, (int)tabla[i].tam, (int)tabla[i].objetos,
+			(int)tabla[i].bloques, (int)tabla[i].en_uso,
+			(int)tabla[i].max_en_uso, (int)tabla[i].reservas);
+}
+
+static unsigned long bloques_mutex(){
+	int i, n;
+
+	n=estadisticas_caches(tabla, NUM_CACHES);
+	for (i=0; i<n; i++)
+		if (tabla[i].nombre[0]=='m')
+			return tabla[i].bloques;
+	return 0;
+}
+
+static int tanda(){
+	int desc[TANDA];
+	char nombre[8];
+	int i, creados=0;
+
+	for (i=0; i<TANDA; i++) {
+		nombre[0]='c';
+		nombre[1]='0'+i/100;
+		nombre[2]='0'+(i/10)%10;
+		nombre[3]='0'+i%10;
+		nombre[4]='\0';
+		if ((desc[i]=crear_mutex(nombre, NO_RECURSIVO))>=0)
+			creados++;
+	}
+	for (i=0; i<TANDA; i++)
+		if (desc[i]>=0)
+			cerrar_mutex(desc[i]);
+	return creados;
+}
+
+int main(){
+	unsigned long antes;
+
+	printf("prueba_caches comienza\n");
+	mostrar("al empezar");
+
+	printf("prueba_caches: primera tanda crea %d mutex\n", tanda());
+	antes=bloques_mutex();
+	mostrar("tras la primera tanda");
+
+	printf("prueba_caches: segunda tanda crea %d mutex\n", tanda());
+	mostrar("tras la segunda tanda");
+	if (bloques_mutex()==antes)
+		printf("prueba_caches: la segunda tanda reutiliza los mutex\n");
+	else
+		printf("prueba_caches: ERROR la cache ha crecido\n");
+
+	printf("prueba_caches termina\n");
+	return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * usuario/prueba_cola.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba las colas de mensajes. La primera copia
+ * crea la cola "cmsg", de 4 mensajes de hasta 16 bytes, y comprueba el
+ * orden por prioridad. Despues lanza otra copia que, al no poder crearla,
+ * la abre y recibe por lotes lo que le envia la primera; cuando esta
+ * termina, la otra no debe quedarse esperando en la cola vacia.
+ *
+ */
+
+#include "servicios.h"
+
+#define MAX_TAM 16
+
+static char bufs[8][MAX_TAM];
+static volatile int abierta;
+
+static void receptora(){
+	int c, i, n, total=0;
+	mensaje v[8];
+
+	c=abrir_cola("cmsg");
+	abierta=1;
+	while (total<10) {
+		for (i=0; i<8; i++) {
+			v[i].buf=bufs[i];
+			v[i].tam=MAX_TAM;
+		}
+		n=recibir_lote(c, v, 8, 0);
+		printf("prueba_cola: la otra copia recibe un lote de %d:", n);
+		for (i=0; i<n; i++)
+			printf(" %s", v[i].buf);
+		printf("\n");
+		total+=n;
+	}
+	v[0].buf=bufs[0];
+	v[0].tam=MAX_TAM;
+	if (recibir_lote(c, v, 1, 0)==-14)
+		printf("prueba_cola: la otra copia se queda sola con la cola vacia. DEBE APARECER\n");
+	printf("prueba_cola: la otra copia termina\n");
+}
+
+int main(){
+	static char *texto[]={"a1", "b5", "c3", "d5", "e0", "f31"};
+	static int prio[]={1, 5, 3, 5, 0, 31};
+	mensaje v[8];
+	char buf[MAX_TAM];
+	int c, i, n;
+
+	if ((c=crear_cola("cmsg", 4, MAX_TAM))<0) {
+		receptora();
+		return 0;
+	}
+	for (i=0; i<6; i++) {
+		v[i].buf=texto[i];
+		v[i].tam=3+(i==5);
+		v[i].prio=prio[i];
+	}
+	n=enviar_lote(c, v, 6, 1);
+	printf("prueba_cola: enviados %d de 6 sin bloquear: deben ser 4\n", n);
+
+	for (i=0; i<8; i++) {
+		v[i].buf=bufs[i];
+		v[i].tam=MAX_TAM;
+	}
+	n=recibir_lote(c, v, 8, 1);
+	printf("prueba_cola: recibidos %d: deben salir b5 d5 c3 a1\n", n);
+	for (i=0; i<n; i++)
+		printf("prueba_cola:   %s (prioridad %d)\n", v[i].buf, v[i].prio);
+
+	v[0].tam=MAX_TAM;
+	if (recibir_lote(c, v, 1, 1)==-13)
+		printf("prueba_cola: recibir sin bloquear de la cola vacia. DEBE APARECER\n");
+	if (enviar(c, buf, MAX_TAM+1, 0)<0)
+		printf("prueba_cola: mensaje demasiado grande. DEBE APARECER\n");
+	if (recibir(c, buf, MAX_TAM-1, 0)<0)
+		printf("prueba_cola: buffer de recepcion pequeo. DEBE APARECER\n");
+
+	if (crear_proceso("prueba_cola")<0)
+		printf("Error creando prueba_cola\n");
+	/* solo no tendria con quien compartir la cola llena */
+	while (!abierta)
+		dormir_ms(10);
+	printf("prueba_cola: envia 10 mensajes: se bloquea cuando hay 4\n");
+	for (i=0; i<10; i++) {
+		buf[0]='0'+i;
+		buf[1]='\0';
+		enviar(c, buf, 2, i%2);
+	}
+	printf("prueba_cola: termina\n");
+	return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * usuario/prueba_condicion.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de las variables condicion
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	int mut, cond;
+
+	printf("prueba_condicion comienza\n");
+
+	if ((mut=crear_mutex("mc", NO_RECURSIVO))<0)
+		printf("error creando mc. NO DEBE APARECER\n");
+
+	if ((cond=crear_condicion("c"))<0)
+		printf("error creando c. NO DEBE APARECER\n");
+
+	/* esperar sin tener el mutex -> error */
+	if (esperar_condicion(cond, mut)<0)
+		printf("esperar_condicion sin tener el mutex. DEBE APARECER\n");
+
+	if (crear_proceso("esperador")<0)
+		printf("Error creando esperador\n");
+	if (crear_proceso("esperador")<0)
+		printf("Error creando esperador\n");
+	if (crear_proceso("esperador")<0)
+		printf("Error creando esperador\n");
+
+	printf("prueba_condicion duerme 1 seg.: los esperadores se bloquearn en c\n");
+	dormir(1);
+
+	lock(mut);
+	printf("prueba_condicion seala c: debe despertar un esperador al soltar mc\n");
+	senalar(cond);
+	unlock(mut);
+
+	dormir(1);
+
+	lock(mut);
+	printf("prueba_condicion difunde c: deben despertar los otros dos, de uno en uno\n");
+	difundir(cond);
+	unlock(mut);
+
+	dormir(1);
+
+	printf("prueba_condicion termina\n");
+	return 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * usuario/prueba_consola.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba que la consola no mezcla las lineas de
+ * distintos procesos. Dos copias escriben sin buffer cada linea en tres
+ * trozos, calculando entre uno y otro para que se les quite el
+ * procesador a mitad de linea. Todas las lineas deben salir enteras.
+ *
+ */
+
+#include "servicios.h"
+
+#define LINEAS 6
+
+static void calcular(){
+	volatile long i;
+
+	for (i=0; i<20000000; i++);
+}
+
+int main(){
+	char *copia="primera";
+	char num[2];
+	int i, b;
+
+	/* la barrera mantiene vivo el nombre hasta que acaben las dos */
+	if ((b=crear_barrera("bcons", 2))<0) {
+		copia="segunda";
+		b=abrir_barrera("bcons");
+	}
+	else if (crear_proceso("prueba_consola")<0)
+		printf("Error creando prueba_consola\n");
+
+	modo_salida(SALIDA_SIN_BUFFER);
+	for (i=0; i<LINEAS; i++) {
+		escribir("prueba_consola: ", 16);
+		calcular();
+		escribir(copia, 7);
+		calcular();
+		num[0]='0'+i;
+		num[1]='\n';
+		escribir(num, 2);
+	}
+	esperar_barrera(b);
+	return 0;
+}
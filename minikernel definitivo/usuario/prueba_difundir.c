@@ -0,0 +1,70 @@
+/*
+ * usuario/prueba_difundir.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba difundir con el mutex libre cuando el
+ * primero en despertar muere sin soltarlo. Crea tres copias de s mismo
+ * que esperan en la condicin; la primera que se despierta provoca una
+ * excepcin de memoria, y su terminacin debe soltar el mutex para que
+ * despierten las otras dos. Las copias se reconocen porque el mutex ya
+ * existe.
+ *
+ */
+
+#include "servicios.h"
+
+#define ESPERADORES 3
+
+static volatile int esperando, despiertos;
+
+static void esperador(){
+	int mut, cond, id;
+
+	id=obtener_id_pr();
+	if ((mut=abrir_mutex("mdif"))<0 || (cond=abrir_condicion("cdif"))<0) {
+		printf("prueba_difundir: error abriendo. NO DEBE APARECER\n");
+		return;
+	}
+	lock(mut);
+	esperando++;
+	if (esperar_condicion(cond, mut)<0)
+		printf("prueba_difundir: error en esperar_condicion. NO DEBE APARECER\n");
+	if (despiertos++==0) {
+		printf("prueba_difundir: esperador (%d) muere con el mutex cogido\n", id);
+		*(volatile int *)0=0;
+	}
+	printf("prueba_difundir: esperador (%d) despierta con el mutex\n", id);
+	unlock(mut);
+}
+
+int main(){
+	int mut, cond, i;
+
+	if ((mut=crear_mutex("mdif", NO_RECURSIVO))<0) {
+		esperador();
+		return 0;
+	}
+	printf("prueba_difundir comienza\n");
+	if ((cond=crear_condicion("cdif"))<0)
+		printf("prueba_difundir: error creando cdif. NO DEBE APARECER\n");
+
+	for (i=0; i<ESPERADORES; i++)
+		if (crear_proceso("prueba_difundir")<0)
+			printf("prueba_difundir: error creando esperador\n");
+	while (esperando<ESPERADORES)
+		dormir_ms(10);
+	dormir_ms(10);
+
+	/* con el mutex libre */
+	difundir(cond);
+	dormir(1);
+
+	printf("prueba_difundir: despiertan %d de %d: deben ser todos\n",
+		despiertos, ESPERADORES);
+	printf("prueba_difundir termina\n");
+	return 0;
+}
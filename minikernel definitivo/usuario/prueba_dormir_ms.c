@@ -0,0 +1,34 @@
+/*
+ * usuario/prueba_dormir_ms.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de dormir_ms y dormir_us.
+ * Los tiempos se redondean hacia arriba a ticks de reloj.
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	int i;
+
+	printf("prueba_dormir_ms comienza\n");
+
+	for (i=0; i<4; i++) {
+		printf("prueba_dormir_ms duerme 250 ms.: debe dormir 25 ticks\n");
+		dormir_ms(250);
+	}
+	printf("prueba_dormir_ms duerme 15 ms.: debe dormir 2 ticks\n");
+	dormir_ms(15);
+	printf("prueba_dormir_ms duerme 1 us.: debe dormir 1 tick\n");
+	dormir_us(1);
+	printf("prueba_dormir_ms duerme 0 us.: no debe dormir\n");
+	dormir_us(0);
+
+	printf("prueba_dormir_ms termina\n");
+	return 0;
+}
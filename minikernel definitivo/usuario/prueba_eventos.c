@@ -0,0 +1,78 @@
+/*
+ * usuario/prueba_eventos.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba los conjuntos de eventos. La primera
+ * copia crea el mutex "ev_mut" y lo vigila desde un conjunto; lanza otra
+ * copia que, al no poder crearlo, lo abre y lo retiene un segundo.
+ *
+ */
+
+#include "servicios.h"
+
+static char *nombre_tipo[]={"terminal", "mutex", "temporizador"};
+
+static void mostrar(char *prueba, evento *ev, int n){
+	int i;
+
+	printf("prueba_eventos: %s: %d eventos\n", prueba, n);
+	for (i=0; i<n; i++)
+		printf("prueba_eventos:   id %d (%s)\n", ev[i].id,
+			nombre_tipo[ev[i].tipo]);
+}
+
+int main(){
+	int m, conj, term, i;
+	char car;
+	evento ev[4];
+
+	if ((m=crear_mutex("ev_mut", NO_RECURSIVO))<0) {
+		m=abrir_mutex("ev_mut");
+		lock(m);
+		printf("prueba_eventos: la otra copia coge el mutex\n");
+		dormir(1);
+		printf("prueba_eventos: la otra copia suelta el mutex\n");
+		unlock(m);
+		return 0;
+	}
+	conj=crear_eventos();
+	anadir_evento(conj, EV_MUTEX, m);
+
+	/* el mutex esta libre: el interes nace listo */
+	mostrar("mutex libre", ev, esperar_eventos(conj, ev, 4, 0));
+	/* ya se ha recogido y no hay otro flanco */
+	mostrar("sin flanco, sin esperar (0)", ev, esperar_eventos(conj, ev, 4, 0));
+
+	if (crear_proceso("prueba_eventos")<0)
+		printf("Error creando prueba_eventos\n");
+	dormir_ms(100);
+	mostrar("mutex cogido, 300 ms (0)", ev, esperar_eventos(conj, ev, 4, 300));
+	mostrar("hasta que lo suelten (1)", ev, esperar_eventos(conj, ev, 4, -1));
+
+	anadir_evento(conj, EV_TEMPORIZADOR, 200);
+	for (i=0; i<3; i++)
+		mostrar("temporizador de 200 ms", ev, esperar_eventos(conj, ev, 4, -1));
+
+	if (anadir_evento(conj, 7, 0)<0)
+		printf("prueba_eventos: fuente no valida. DEBE APARECER\n");
+	cerrar_mutex(conj);
+	if (esperar_eventos(conj, ev, 4, 0)<0)
+		printf("prueba_eventos: conjunto cerrado. DEBE APARECER\n");
+
+	term=crear_eventos();
+	anadir_evento(term, EV_TERMINAL, 0);
+	printf("prueba_eventos: pulsa una tecla en 5 segundos\n");
+	if (esperar_eventos(term, ev, 4, 5000)>0) {
+		car=leer_caracter();
+		printf("prueba_eventos: terminal listo: %c\n", car);
+	}
+	else
+		printf("prueba_eventos: no se ha pulsado nada\n");
+
+	printf("prueba_eventos: termina\n");
+	return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * usuario/prueba_int.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que muestra las medidas de las interrupciones. Las
+ * pone a cero, hace llamadas, duerme y gasta CPU, y despues muestra por
+ * vector cuantas ha habido y su duracion, con el histograma, y las
+ * ventanas mas largas con el reloj inhibido.
+ *
+ */
+
+#include "servicios.h"
+
+#define LLAMADAS 1000
+
+static char *nombres[NUM_VECTORES]={"aritmetica", "memoria", "reloj",
+				    "terminal", "llamada", "software"};
+
+static est_interrupciones e;
+
+int main(){
+	int i, j;
+	void *pila;
+	volatile int tot=0;
+
+	printf("prueba_int comienza\n");
+	estadisticas_int(&e, 1);
+	for (i=0; i<LLAMADAS; i++)
+		obtener_pila(&pila, 0);
+	dormir_ms(200);
+	for (i=0; i<50000000; i++)
+		tot+=i;
+	estadisticas_int(&e, 0);
+
+	printf("prueba_int: %d ciclos por tick\n", (int)e.ciclos_por_tick);
+	for (i=0; i<NUM_VECTORES; i++) {
+		if (e.vectores[i].veces==0)
+			continue;
+		printf("prueba_int: %s: %d veces, media %d max %d ciclos\n",
+			nombres[i], (int)e.vectores[i].veces,
+			(int)(e.vectores[i].ciclos_total/e.vectores[i].veces),
+			(int)e.vectores[i].ciclos_max);
+		printf("  histograma (2^10, 2^11, ...):");
+		for (j=0; j<NUM_CUBOS_INT; j++)
+			printf(" %d", (int)e.vectores[i].histograma[j]);
+		printf("\n");
+	}
+	if (e.vectores[4].veces>=LLAMADAS)
+		printf("prueba_int: se cuentan todas las llamadas. DEBE APARECER\n");
+	if (e.vectores[2].veces>=20)
+		printf("prueba_int: se cuentan los ticks del sueo. DEBE APARECER\n");
+	for (i=0; i<NUM_VENTANAS && e.ventanas[i].ciclos; i++)
+		printf("prueba_int: reloj inhibido %d ciclos en %s:%d\n",
+			(int)e.ventanas[i].ciclos, e.ventanas[i].funcion,
+			e.ventanas[i].linea);
+
+	printf("prueba_int termina\n");
+	return 0;
+}
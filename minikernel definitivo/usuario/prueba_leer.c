@@ -0,0 +1,37 @@
+/*
+ * usuario/prueba_leer.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de la lectura en bloque del
+ * terminal. Lo tecleado mientras duerme se guarda en el buffer del
+ * terminal, y lo que no cabe se pierde.
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	char buf[32];
+	int i, n;
+
+	printf("prueba_leer: pulsa mas de 8 caracteres en 3 segundos\n");
+	dormir(3);
+	n=leer(buf, sizeof(buf));
+	printf("prueba_leer: leidos %d de golpe: deben ser como mucho 8\n", n);
+	for (i=0; i<n; i++)
+		printf("prueba_leer: %c\n", buf[i]);
+
+	printf("prueba_leer: pulsa un caracter mas\n");
+	n=leer(buf, sizeof(buf));
+	printf("prueba_leer: leidos %d: %c\n", n, buf[0]);
+
+	if (leer(buf, 0)<0)
+		printf("prueba_leer: leer de 0 caracteres. DEBE APARECER\n");
+
+	printf("prueba_leer: termina\n");
+	return 0;
+}
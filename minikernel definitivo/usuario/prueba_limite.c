@@ -0,0 +1,60 @@
+/*
+ * usuario/prueba_limite.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba el limite de memoria de un proceso.
+ * Comprueba que la tuberia que crea se le carga y se le descarga al
+ * cerrarla. Despues baja su limite a lo que ya usa mas 2MB, lo justo
+ * para dos trozos del monticulo, y reserva
+ * bloques de 512KB hasta que el kernel deja de ampliarle el monticulo.
+ *
+ */
+
+#include "servicios.h"
+
+#define KB 1024
+
+static void mostrar(char *momento){
+	est_memoria e;
+
+	estadisticas_memoria(-1, &e);
+	printf("prueba_limite: %s: en uso %d max %d limite %d pila %d monticulo %d ipc %d fallos %d\n",
+		momento, (int)e.en_uso, (int)e.max_en_uso, (int)e.limite,
+		(int)e.pila, (int)e.monticulo, (int)e.ipc, (int)e.fallos);
+}
+
+int main(){
+	est_memoria e;
+	int n, tub;
+
+	printf("prueba_limite comienza\n");
+	mostrar("al empezar");
+
+	tub=crear_tuberia(0);
+	mostrar("con una tuberia");
+	cerrar_mutex(tub);
+	mostrar("al cerrarla");
+
+	estadisticas_memoria(-1, &e);
+	limitar_memoria(e.en_uso+2*KB*KB);
+	if (limitar_memoria(e.limite)<0)
+		printf("prueba_limite: no puede subir su limite. DEBE APARECER\n");
+
+	for (n=0; malloc(512*KB)!=0; n++)
+		;
+	printf("prueba_limite: %d bloques de 512KB antes del limite: deben ser 4\n", n);
+	mostrar("en el limite");
+
+	if (crear_tuberia(0)<0)
+		printf("prueba_limite: sin sitio para una tuberia. DEBE APARECER\n");
+	limitar_memoria(0);
+	if (crear_proceso("simplon")<0)
+		printf("prueba_limite: un hijo sin sitio para su pila no se crea. DEBE APARECER\n");
+
+	printf("prueba_limite termina\n");
+	return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * usuario/prueba_malloc.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba la memoria dinamica. Reserva bloques
+ * grandes y comprueba que al liberarlos el buddy los junta de nuevo sin
+ * pedir mas al kernel, y despues objetos pequeos que no se deben pisar.
+ * Al final llena varios trozos del monticulo, que el kernel no tiene por
+ * que dar seguidos.
+ *
+ */
+
+#include "servicios.h"
+
+#define NUM_PEQ 500
+#define KB 1024
+
+static void mostrar(char *momento){
+	est_malloc e;
+
+	estadisticas_malloc(&e);
+	printf("prueba_malloc: %s: en uso %d max %d reservas %d monticulo %d\n",
+		momento, (int)e.en_uso, (int)e.max_en_uso, (int)e.reservas,
+		(int)e.monticulo);
+}
+
+int main(){
+	char *peq[NUM_PEQ];
+	char *a, *b, *c, *d, *g[3];
+	int i, j, bien=1;
+	est_malloc e;
+	unsigned long antes;
+
+	printf("prueba_malloc comienza\n");
+
+	a=malloc(300*KB);
+	b=malloc(200*KB);
+	c=malloc(100*KB);
+	for (i=0; i<100*KB; i++)
+		a[i]=b[i]=c[i]=1;
+	mostrar("con tres bloques grandes");
+	estadisticas_malloc(&e);
+	antes=e.monticulo;
+	free(a);
+	free(b);
+	free(c);
+	/* juntos de nuevo caben en el trozo que ya se pidio */
+	d=malloc(1024*KB);
+	estadisticas_malloc(&e);
+	if (d && e.monticulo==antes)
+		printf("prueba_malloc: el buddy junta los bloques liberados\n");
+	else
+		printf("prueba_malloc: ERROR los bloques no se juntan\n");
+	free(d);
+
+	for (i=0; i<NUM_PEQ; i++) {
+		peq[i]=malloc(1+i%200);
+		for (j=0; j<1+i%200; j++)
+			peq[i][j]=i;
+	}
+	for (i=0; i<NUM_PEQ; i++)
+		for (j=0; j<1+i%200; j++)
+			if (peq[i][j]!=(char)i)
+				bien=0;
+	printf("prueba_malloc: objetos pequeos %s\n", bien ? "intactos" : "ERROR pisados");
+	mostrar("tras los pequeos");
+	a=peq[7];
+	free(peq[7]);
+	peq[7]=malloc(8);
+	if (peq[7]==a)
+		printf("prueba_malloc: se reutiliza el objeto liberado\n");
+	for (i=0; i<NUM_PEQ; i++)
+		free(peq[i]);
+
+	a=calloc(10, 100);
+	for (i=0, bien=1; i<1000; i++)
+		if (a[i])
+			bien=0;
+	a=realloc(a, 5000);
+	printf("prueba_malloc: calloc %s, realloc %s\n", bien ? "a cero" : "ERROR",
+		a ? "bien" : "ERROR");
+	free(a);
+	if (malloc(16*KB*KB)==0)
+		printf("prueba_malloc: un bloque demasiado grande falla. DEBE APARECER\n");
+
+	for (i=0; i<3; i++)
+		for (j=0, g[i]=malloc(1024*KB); g[i] && j<1024*KB; j+=4*KB)
+			g[i][j]=i;
+	for (i=0, bien=1; i<3; i++)
+		for (j=0; j<1024*KB; j+=4*KB)
+			if (g[i]==0 || g[i][j]!=(char)i)
+				bien=0;
+	printf("prueba_malloc: tres trozos enteros %s\n", bien ? "intactos" : "ERROR");
+	for (i=0; i<3; i++)
+		free(g[i]);
+	estadisticas_malloc(&e);
+	antes=e.monticulo;
+	d=malloc(1024*KB);
+	estadisticas_malloc(&e);
+	if (d && e.monticulo==antes)
+		printf("prueba_malloc: se reutiliza un trozo liberado\n");
+	free(d);
+	mostrar("al terminar");
+
+	printf("prueba_malloc termina\n");
+	return 0;
+}
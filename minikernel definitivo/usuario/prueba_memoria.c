@@ -0,0 +1,91 @@
+/*
+ * usuario/prueba_memoria.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba la memoria compartida. La primera copia
+ * crea el segmento "mem" y lanza otra que, al no poder crearlo, lo abre.
+ * Las dos suman en el mismo contador protegido por un mutex y se esperan
+ * en una barrera.
+ *
+ */
+
+#include "servicios.h"
+
+#define VUELTAS 1000
+
+struct datos {
+	int contador;
+	int tabla[1000];
+};
+
+static void sumar(struct datos *d, int m, int b){
+	int i;
+
+	for (i=0; i<VUELTAS; i++) {
+		lock(m);
+		d->contador++;
+		unlock(m);
+	}
+	esperar_barrera(b);
+}
+
+int main(){
+	struct datos *d, *otro;
+	char *p1, *p2;
+	int mem, m, b, i, ceros=1;
+
+	if ((mem=crear_memoria_compartida("mem", sizeof(struct datos), (void **)&d))<0) {
+		abrir_memoria_compartida("mem", (void **)&otro);
+		m=abrir_mutex("mmem");
+		b=abrir_barrera("bmem");
+		sumar(otro, m, b);
+		printf("prueba_memoria: la otra copia termina\n");
+		return 0;
+	}
+	for (i=0; i<1000; i++)
+		if (d->tabla[i]!=0)
+			ceros=0;
+	printf("prueba_memoria: segmento a ceros: %s\n", ceros ? "si" : "no");
+	m=crear_mutex("mmem", NO_RECURSIVO);
+	b=crear_barrera("bmem", 2);
+
+	if (crear_proceso("prueba_memoria")<0)
+		printf("Error creando prueba_memoria\n");
+	sumar(d, m, b);
+	printf("prueba_memoria: contador %d: debe ser %d\n", d->contador, 2*VUELTAS);
+
+	cerrar_mutex(mem);
+	dormir(1);
+	if (abrir_memoria_compartida("mem", (void **)&otro)<0)
+		printf("prueba_memoria: segmento destruido al cerrarlo todos. DEBE APARECER\n");
+	if (crear_memoria_compartida("mem2", 0, (void **)&otro)<0)
+		printf("prueba_memoria: segmento de 0 bytes. DEBE APARECER\n");
+
+	/* uno de 1 byte, destruido y vuelto a crear sobre el mismo bloque */
+	for (i=0; i<2; i++) {
+		if ((mem=crear_memoria_compartida("mem3", 1, (void **)&otro))<0) {
+			printf("prueba_memoria: error creando mem3. NO DEBE APARECER\n");
+			continue;
+		}
+		*(char *)otro='x';
+		cerrar_mutex(mem);
+	}
+
+	/* dos pequeos salen del bloque grande que se acaba de liberar */
+	if ((mem=crear_memoria_compartida("mem4", sizeof(struct datos), (void **)&d))<0)
+		printf("prueba_memoria: error creando mem4. NO DEBE APARECER\n");
+	cerrar_mutex(mem);
+	if (crear_memoria_compartida("mem5", 100, (void **)&p1)<0 ||
+	    crear_memoria_compartida("mem6", 100, (void **)&p2)<0)
+		printf("prueba_memoria: error creando mem5 y mem6. NO DEBE APARECER\n");
+	else if (p1>=(char *)d && p1<(char *)(d+1) && p2>=(char *)d &&
+	    p2<(char *)(d+1) && (p2-p1>=100 || p1-p2>=100))
+		printf("prueba_memoria: mem5 y mem6 dentro del bloque de mem4. DEBE APARECER\n");
+
+	printf("prueba_memoria: termina\n");
+	return 0;
+}
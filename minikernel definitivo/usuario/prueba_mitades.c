@@ -0,0 +1,50 @@
+/*
+ * usuario/prueba_mitades.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba el trabajo aplazado del reloj. Dos
+ * copias gastan CPU sin hacer llamadas: la interrupcion de reloj solo
+ * pide el cambio de proceso y la interrupcion software lo hace al volver
+ * a modo usuario, asi que sus vueltas deben intercalarse. Mientras, un
+ * dormilon despierta desde la mitad inferior del reloj.
+ *
+ */
+
+#include "servicios.h"
+
+#define VUELTAS 5
+#define ITER 400000000
+
+static volatile int tot;
+
+static void gastar(char *quien){
+	int i, v;
+
+	for (v=0; v<VUELTAS; v++) {
+		for (i=0; i<ITER; i++)
+			tot=i;
+		printf("prueba_mitades: %s vuelta %d\n", quien, v);
+	}
+}
+
+int main(){
+	int b;
+
+	if ((b=crear_barrera("bmit", 2))<0) {
+		b=abrir_barrera("bmit");
+		esperar_barrera(b);
+		gastar("segunda");
+		return 0;
+	}
+	printf("prueba_mitades comienza: las vueltas DEBEN INTERCALARSE\n");
+	crear_proceso("prueba_mitades");
+	crear_proceso("dormilon");
+	esperar_barrera(b);
+	gastar("primera");
+	printf("prueba_mitades termina\n");
+	return 0;
+}
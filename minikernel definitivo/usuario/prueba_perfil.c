@@ -0,0 +1,60 @@
+/*
+ * usuario/prueba_perfil.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba del perfil de los mutex.
+ * La primera copia crea los mutex y lanza otras dos, que se dan cuenta
+ * de que no son la primera porque el mutex ya existe.
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	int caliente, frio;
+
+	if ((caliente=crear_mutex("caliente", NO_RECURSIVO))<0) {
+		/* no somos la primera copia: competimos por el mutex */
+		if ((caliente=abrir_mutex("caliente"))<0)
+			printf("error abriendo caliente. NO DEBE APARECER\n");
+		if (lock(caliente)<0)
+			printf("error en lock de mutex. NO DEBE APARECER\n");
+		printf("prueba_perfil (%d) obtiene caliente y lo retiene 1 seg.\n",
+			obtener_id_pr());
+		dormir(1);
+		if (unlock(caliente)<0)
+			printf("error en unlock de mutex. NO DEBE APARECER\n");
+		return 0;
+	}
+	printf("prueba_perfil comienza\n");
+
+	if ((frio=crear_mutex("frio", NO_RECURSIVO))<0)
+		printf("error creando frio. NO DEBE APARECER\n");
+	if (lock(frio)<0 || unlock(frio)<0)
+		printf("error en frio. NO DEBE APARECER\n");
+
+	if (lock(caliente)<0)
+		printf("error en lock de mutex. NO DEBE APARECER\n");
+	if (crear_proceso("prueba_perfil")<0)
+		printf("Error creando prueba_perfil\n");
+	if (crear_proceso("prueba_perfil")<0)
+		printf("Error creando prueba_perfil\n");
+
+	printf("prueba_perfil duerme 1 seg. con caliente cogido\n");
+	dormir(1);
+	if (unlock(caliente)<0)
+		printf("error en unlock de mutex. NO DEBE APARECER\n");
+
+	/* cuando las copias han terminado, caliente debe salir el primero */
+	dormir(3);
+	if (crear_proceso("perfil_mutex")<0)
+		printf("Error creando perfil_mutex\n");
+	dormir(1);
+
+	printf("prueba_perfil termina\n");
+	return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * usuario/prueba_rwlock.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de los rwlock
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	int desc;
+
+	printf("prueba_rwlock comienza\n");
+
+	if ((desc=crear_rwlock("rw", PREF_ESCRITURA))<0)
+		printf("error creando rw. NO DEBE APARECER\n");
+
+	if (abrir_mutex("rw")>=0)
+		printf("abrir rw como mutex no debe funcionar. NO DEBE APARECER\n");
+
+	if (lock(desc)>=0)
+		printf("lock de mutex sobre un rwlock. NO DEBE APARECER\n");
+
+	if (lock_escritura(desc)<0)
+		printf("error en lock_escritura. NO DEBE APARECER\n");
+
+	if (crear_proceso("lector_rw")<0)
+		printf("Error creando lector_rw\n");
+	if (crear_proceso("lector_rw")<0)
+		printf("Error creando lector_rw\n");
+	if (crear_proceso("lector_rw")<0)
+		printf("Error creando lector_rw\n");
+
+	printf("prueba_rwlock duerme 1 seg.: los lectores se bloquearn\n");
+	dormir(1);
+
+	/* Debe despertar de una vez a los tres lectores */
+	printf("prueba_rwlock libera rw: deben entrar los tres lectores a la vez\n");
+	if (unlock_rw(desc)<0)
+		printf("error en unlock_rw. NO DEBE APARECER\n");
+
+	/* Debe esperar a que salgan los tres lectores */
+	if (lock_escritura(desc)<0)
+		printf("error en lock_escritura. NO DEBE APARECER\n");
+
+	printf("prueba_rwlock escribe tras salir los lectores\n");
+
+	if (unlock_rw(desc)<0)
+		printf("error en unlock_rw. NO DEBE APARECER\n");
+
+	printf("prueba_rwlock termina\n");
+	return 0;
+}
@@ -0,0 +1,48 @@
+/*
+ * usuario/prueba_salida.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba los modos de la salida con buffer. La
+ * primera copia lanza otra que escribe mientras ella duerme con texto
+ * pendiente en el buffer.
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	int i;
+
+	if (crear_mutex("msal", NO_RECURSIVO)<0) {
+		printf("prueba_salida: la otra copia escribe mientras la primera duerme\n");
+		return 0;
+	}
+	if (crear_proceso("prueba_salida")<0)
+		printf("Error creando prueba_salida\n");
+
+	modo_salida(SALIDA_COMPLETA);
+	for (i=0; i<3; i++)
+		printf("prueba_salida: linea %d en modo completo: debe salir despues de la otra copia\n", i);
+	dormir(1);
+	vaciar_salida();
+
+	modo_salida(SALIDA_LINEA);
+	printf("prueba_salida: en modo linea ");
+	dormir(1);
+	printf("la linea sale entera al acabarla\n");
+
+	modo_salida(SALIDA_SIN_BUFFER);
+	printf("prueba_salida: sin buffer ");
+	printf("cada printf es una llamada\n");
+
+	if (modo_salida(7)<0)
+		printf("prueba_salida: modo no valido. DEBE APARECER\n");
+
+	modo_salida(SALIDA_COMPLETA);
+	printf("prueba_salida: pendiente al volver de main: DEBE APARECER\n");
+	return 0;
+}
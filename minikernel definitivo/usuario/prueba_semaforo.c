@@ -0,0 +1,48 @@
+/*
+ * usuario/prueba_semaforo.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de los semaforos
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	int sem;
+
+	printf("prueba_semaforo comienza\n");
+
+	if ((sem=crear_semaforo("s", 0))<0)
+		printf("error creando s. NO DEBE APARECER\n");
+
+	if (sem_esperar(sem, 0)<0)
+		printf("sem_esperar de 0 unidades. DEBE APARECER\n");
+
+	if (crear_proceso("consumidor")<0)
+		printf("Error creando consumidor\n");
+	if (crear_proceso("consumidor")<0)
+		printf("Error creando consumidor\n");
+	if (crear_proceso("consumidor")<0)
+		printf("Error creando consumidor\n");
+
+	printf("prueba_semaforo duerme 1 seg.: los consumidores se bloquearn\n");
+	dormir(1);
+
+	printf("prueba_semaforo suma 5 unidades: deben despertar dos consumidores\n");
+	if (sem_senalar(sem, 5)<0)
+		printf("error en sem_senalar. NO DEBE APARECER\n");
+	dormir(1);
+
+	printf("prueba_semaforo suma 1 unidad: debe despertar el tercer consumidor\n");
+	if (sem_senalar(sem, 1)<0)
+		printf("error en sem_senalar. NO DEBE APARECER\n");
+	dormir(1);
+
+	printf("prueba_semaforo termina\n");
+	return 0;
+}
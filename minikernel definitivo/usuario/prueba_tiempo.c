@@ -0,0 +1,43 @@
+/*
+ * usuario/prueba_tiempo.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de obtener_tiempo
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	unsigned long long ini, fin, real, ticks;
+	int i;
+
+	printf("prueba_tiempo comienza\n");
+
+	if (obtener_tiempo(7, &ini)<0)
+		printf("reloj inexistente. DEBE APARECER\n");
+
+	obtener_tiempo(TIEMPO_REAL, &real);
+	printf("tiempo real: %lu s. desde 1970\n",
+		(unsigned long)(real/1000000000ULL));
+
+	obtener_tiempo(TIEMPO_MONOTONICO, &ini);
+	for (i=0; i<4; i++) {
+		dormir_ms(500);
+		obtener_tiempo(TIEMPO_MONOTONICO, &fin);
+		if (fin<ini)
+			printf("el tiempo monotonico retrocede. NO DEBE APARECER\n");
+		printf("prueba_tiempo ha dormido %lu ms.: deben ser unos 500\n",
+			(unsigned long)((fin-ini)/1000000));
+		ini=fin;
+	}
+	obtener_tiempo(TIEMPO_TICKS, &ticks);
+	printf("ticks desde el arranque: %lu\n", (unsigned long)ticks);
+
+	printf("prueba_tiempo termina\n");
+	return 0;
+}
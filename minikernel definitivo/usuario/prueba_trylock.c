@@ -0,0 +1,53 @@
+/*
+ * usuario/prueba_trylock.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de trylock y de
+ * lock_temporizado. La primera copia crea el mutex y lanza otra, que se
+ * da cuenta de que no es la primera porque el mutex ya existe.
+ *
+ */
+
+#include "servicios.h"
+
+int main(){
+	int desc;
+
+	if ((desc=crear_mutex("mt", NO_RECURSIVO))<0) {
+		if ((desc=abrir_mutex("mt"))<0)
+			printf("error abriendo mt. NO DEBE APARECER\n");
+		if (trylock(desc)<0)
+			printf("trylock de mt ocupado falla. DEBE APARECER\n");
+		if (lock_temporizado(desc, 500)<0)
+			printf("lock_temporizado de 500 ms vence. DEBE APARECER\n");
+		printf("segunda copia espera hasta 3 segs.: debe obtener mt al liberarlo la primera\n");
+		if (lock_temporizado(desc, 3000)<0)
+			printf("error en lock_temporizado. NO DEBE APARECER\n");
+		printf("segunda copia obtiene mt\n");
+		if (unlock(desc)<0)
+			printf("error en unlock de mutex. NO DEBE APARECER\n");
+		if (trylock(desc)<0)
+			printf("error en trylock de mt libre. NO DEBE APARECER\n");
+		printf("segunda copia termina\n");
+		return 0;
+	}
+	printf("prueba_trylock comienza\n");
+
+	if (trylock(desc)<0)
+		printf("error en trylock de mt libre. NO DEBE APARECER\n");
+	if (crear_proceso("prueba_trylock")<0)
+		printf("Error creando prueba_trylock\n");
+
+	printf("prueba_trylock duerme 2 segs. con mt cogido\n");
+	dormir(2);
+	if (unlock(desc)<0)
+		printf("error en unlock de mutex. NO DEBE APARECER\n");
+	dormir(1);
+
+	printf("prueba_trylock termina\n");
+	return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * usuario/prueba_tuberia.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba las tuberias. La primera copia crea una
+ * tuberia anonima, que es su descriptor 0, y la tuberia "tub", y lanza
+ * otra copia que hereda la anonima con el mismo descriptor. Por la
+ * anonima se mandan mas datos de los que caben y la otra copia contesta
+ * por "tub".
+ *
+ */
+
+#include "servicios.h"
+
+#define TOTAL 10000
+
+static char datos[TOTAL];
+
+static void hija(){
+	int nom, n, total=0, lecturas=0, bien=1, i;
+	char buf[3000];
+
+	nom=abrir_tuberia("tub");
+	while (total<TOTAL && (n=leer_tuberia(0, buf, sizeof(buf)))>0) {
+		for (i=0; i<n; i++)
+			if (buf[i]!=(char)((total+i)%251))
+				bien=0;
+		total+=n;
+		lecturas++;
+	}
+	printf("prueba_tuberia: la otra copia lee %d bytes en %d lecturas\n",
+		total, lecturas);
+	escribir_tuberia(nom, bien ? "bien" : "mal!", 4);
+	if (leer_tuberia(0, buf, sizeof(buf))==0)
+		printf("prueba_tuberia: fin de la anonima al cerrarla la primera. DEBE APARECER\n");
+	printf("prueba_tuberia: la otra copia termina\n");
+}
+
+int main(){
+	int anon, nom, sola, i, n;
+	char resp[5];
+
+	anon=crear_tuberia(0);
+	if ((nom=crear_tuberia("tub"))<0) {
+		hija();
+		return 0;
+	}
+	for (i=0; i<TOTAL; i++)
+		datos[i]=(char)(i%251);
+
+	if (crear_proceso("prueba_tuberia")<0)
+		printf("Error creando prueba_tuberia\n");
+	n=escribir_tuberia(anon, datos, TOTAL);
+	printf("prueba_tuberia: escritos %d bytes: la tuberia tiene menos sitio\n", n);
+
+	n=leer_tuberia(nom, resp, 4);
+	resp[n]='\0';
+	printf("prueba_tuberia: la otra copia contesta %s\n", resp);
+	cerrar_mutex(anon);
+	if (leer_tuberia(anon, resp, 4)<0)
+		printf("prueba_tuberia: leer de la tuberia cerrada. DEBE APARECER\n");
+
+
+	sola=crear_tuberia(0);
+	if (leer_tuberia(sola, resp, 4)==0)
+		printf("prueba_tuberia: leer sin nadie mas en la tuberia. DEBE APARECER\n");
+	if (crear_tuberia("tub")<0)
+		printf("prueba_tuberia: tuberia con nombre repetido. DEBE APARECER\n");
+
+	printf("prueba_tuberia: termina\n");
+	return 0;
+}
@@ -0,0 +1,35 @@
+/*
+ * usuario/trabajador.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de la prueba de las barreras:
+ * ninguna fase debe empezar hasta que los tres trabajadores acaben la
+ * anterior
+ *
+ */
+
+#include "servicios.h"
+
+#define FASES 3
+
+int main(){
+	int bar, id, fase;
+
+	id=obtener_id_pr();
+
+	if ((bar=abrir_barrera("b"))<0)
+		printf("error abriendo b. NO DEBE APARECER\n");
+
+	for (fase=0; fase<FASES; fase++) {
+		printf("trabajador (%d) acaba la fase %d\n", id, fase);
+		if (esperar_barrera(bar)==1)
+			printf("trabajador (%d) es el ltimo de la fase %d\n", id, fase);
+	}
+
+	printf("trabajador (%d) termina\n", id);
+	return 0;
+}
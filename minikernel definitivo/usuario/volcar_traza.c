@@ -0,0 +1,202 @@
+/*
+ * usuario/volcar_traza.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que activa la traza de eventos del kernel, crea dos
+ * copias de si mismo que compiten por un mutex y duermen, y al acabar saca
+ * la traza y la escribe en el formato JSON de trazas de Chrome (Perfetto o
+ * chrome://tracing), entre dos lineas de marca. Cada proceso tiene su pista
+ * con los intervalos en que ejecuta y las interrupciones que le llegan; la
+ * espera sin procesos listos va a una pista aparte. Las copias se
+ * reconocen porque el mutex ya existe.
+ *
+ */
+
+#include "servicios.h"
+
+#define VUELTAS 5
+#define MAX_PISTAS 64
+#define PISTA_INACTIVO -1
+#define TAM_LECTURA 256
+#define US_POR_TICK 10000	/* el kernel va a 100 ticks por segundo */
+
+static char *nombres_int[NUM_VECTORES]={"int aritmetica", "int memoria",
+	"int reloj", "int terminal", "llamada", "int software"};
+
+static char *nombres_ev[]={"sale", "entra", "inactivo", "activo", "crear",
+	"terminar", "pide lock", "lock", "unlock", "dormir", "despertar"};
+
+static registro_traza regs[TAM_LECTURA];
+static est_interrupciones e;
+
+static int ejecutando[MAX_PISTAS];	/* intervalo "ejecuta" abierto */
+static int prof_int[MAX_PISTAS];	/* interrupciones abiertas */
+static int vista[MAX_PISTAS];		/* ya tiene nombre */
+static int inactivo;
+static int hay_eventos;
+static int con_origen;
+static unsigned long long origen, ultimo;
+
+static void trabajador(int desc){
+	int i, j;
+	volatile int tot=0;
+
+	for (i=0; i<VUELTAS; i++) {
+		lock(desc);
+		for (j=0; j<2000000; j++)
+			tot+=j;
+		unlock(desc);
+		dormir_ms(20);
+	}
+}
+
+/* Microsegundos desde el primer registro */
+static int a_us(unsigned long long ciclos){
+	if (e.ciclos_por_tick==0)
+		return 0;
+	return (int)((ciclos-origen)*US_POR_TICK/e.ciclos_por_tick);
+}
+
+static void separar(){
+	if (hay_eventos)
+		printf(",\n");
+	hay_eventos=1;
+}
+
+static void nombrar(int pista){
+	if (pista<0 || pista>=MAX_PISTAS || vista[pista])
+		return;
+	vista[pista]=1;
+	separar();
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,"
+	       "\"args\":{\"name\":\"proceso %d\"}}", pista, pista);
+}
+
+static void intervalo(char *nombre, char fase, int pista, int ts){
+	separar();
+	if (fase=='B')
+		printf("{\"name\":\"%s\",\"ph\":\"B\",\"pid\":0,\"tid\":%d,"
+		       "\"ts\":%d}", nombre, pista, ts);
+	else
+		printf("{\"ph\":\"E\",\"pid\":0,\"tid\":%d,\"ts\":%d}",
+		       pista, ts);
+}
+
+static void instante(registro_traza *r, int ts){
+	separar();
+	printf("{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":0,"
+	       "\"tid\":%d,\"ts\":%d,\"args\":{\"dato1\":%d,\"dato2\":%d}}",
+	       nombres_ev[r->tipo], r->proc, ts, r->dato1, r->dato2);
+}
+
+static void volcar(registro_traza *r){
+	int ts, p=r->dato1, q=r->proc;
+
+	if (!con_origen) {
+		origen=r->ciclos;
+		con_origen=1;
+	}
+	ultimo=r->ciclos;
+	ts=a_us(r->ciclos);
+	nombrar(q);
+	switch (r->tipo) {
+	case TR_ENTRA:
+		nombrar(p);
+		if (p>=0 && p<MAX_PISTAS && !ejecutando[p]) {
+			ejecutando[p]=1;
+			intervalo("ejecuta", 'B', p, ts);
+		}
+		break;
+	case TR_SALE:
+		if (p>=0 && p<MAX_PISTAS && ejecutando[p]) {
+			ejecutando[p]=0;
+			intervalo(0, 'E', p, ts);
+		}
+		break;
+	case TR_INACTIVO:
+		inactivo=1;
+		intervalo("sin listos", 'B', PISTA_INACTIVO, ts);
+		break;
+	case TR_ACTIVO:
+		if (inactivo) {
+			inactivo=0;
+			intervalo(0, 'E', PISTA_INACTIVO, ts);
+		}
+		break;
+	case TR_INT_ENTRA:
+		if (q>=0 && q<MAX_PISTAS && p>=0 && p<NUM_VECTORES) {
+			prof_int[q]++;
+			intervalo(nombres_int[p], 'B', q, ts);
+		}
+		break;
+	case TR_INT_SALE:
+		if (q>=0 && q<MAX_PISTAS && prof_int[q]>0) {
+			prof_int[q]--;
+			intervalo(0, 'E', q, ts);
+		}
+		break;
+	default:
+		instante(r, ts);
+	}
+}
+
+/* Cierra lo que siga abierto al acabar la traza */
+static void cerrar(){
+	int i, ts=a_us(ultimo);
+
+	for (i=0; i<MAX_PISTAS; i++) {
+		for (; prof_int[i]>0; prof_int[i]--)
+			intervalo(0, 'E', i, ts);
+		if (ejecutando[i])
+			intervalo(0, 'E', i, ts);
+	}
+	if (inactivo)
+		intervalo(0, 'E', PISTA_INACTIVO, ts);
+}
+
+int main(){
+	int desc, n, i, total=0;
+	unsigned long perdidos, perdidos_total=0;
+
+	if ((desc=crear_mutex("mtraza", NO_RECURSIVO))<0) {
+		if ((desc=abrir_mutex("mtraza"))<0) {
+			printf("volcar_traza: error abriendo mtraza\n");
+			return 1;
+		}
+		trabajador(desc);
+		return 0;
+	}
+
+	printf("volcar_traza comienza\n");
+	activar_traza(TRAZA_TODO);
+	if (crear_proceso("volcar_traza")<0 || crear_proceso("volcar_traza")<0)
+		printf("volcar_traza: error creando procesos\n");
+	dormir(2);
+	activar_traza(0);
+	estadisticas_int(&e, 0);	/* para pasar los ciclos a tiempo */
+
+	printf("=== TRAZA JSON ===\n");
+	printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	separar();
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,"
+	       "\"args\":{\"name\":\"sin listos\"}}", PISTA_INACTIVO);
+	while ((n=leer_traza(regs, TAM_LECTURA, &perdidos))>0) {
+		perdidos_total+=perdidos;
+		for (i=0; i<n; i++)
+			volcar(&regs[i]);
+		total+=n;
+	}
+	cerrar();
+	printf("\n]}\n");
+	printf("=== FIN TRAZA ===\n");
+	printf("volcar_traza: %d registros, %d perdidos\n", total,
+	       (int)perdidos_total);
+
+	cerrar_mutex(desc);
+	printf("volcar_traza termina\n");
+	return 0;
+}